@@ -0,0 +1,29 @@
+# Checks the text size of EXECUTABLE, as reported by SIZE_TOOL (size, in its default Berkeley format),
+# against the budget in ClaraSizeBudget.cmake for the build type CONFIG. Run as a script:
+#   cmake -DSIZE_TOOL=size -DEXECUTABLE=ClaraSizeBenchmark -DCONFIG=Release -P CheckCodeSize.cmake
+include(${CMAKE_CURRENT_LIST_DIR}/ClaraSizeBudget.cmake)
+
+if(NOT CONFIG)
+    set(CONFIG None)
+endif()
+string(TOUPPER ${CONFIG} config)
+set(budget ${CLARA_TEXT_SIZE_BUDGET_${config}})
+if(NOT budget)
+    message(FATAL_ERROR "No text size budget for ${CONFIG} builds in ClaraSizeBudget.cmake")
+endif()
+
+execute_process(COMMAND ${SIZE_TOOL} ${EXECUTABLE} OUTPUT_VARIABLE output RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${SIZE_TOOL} failed on ${EXECUTABLE}")
+endif()
+
+# A line of headings, then text, data, bss, dec, hex and the file name
+if(NOT output MATCHES "\n[ \t]*([0-9]+)")
+    message(FATAL_ERROR "Unexpected output from ${SIZE_TOOL}:\n${output}")
+endif()
+set(text ${CMAKE_MATCH_1})
+
+message(STATUS "Text size of ${EXECUTABLE}: ${text} bytes (budget for ${CONFIG} builds: ${budget})")
+if(text GREATER budget)
+    message(FATAL_ERROR "Text size of ${text} bytes is over the budget of ${budget} for ${CONFIG} builds")
+endif()
@@ -27,15 +27,60 @@
 #   endif
 #endif
 
-#include "clara_textflow.hpp"
+#ifndef CLARA_CONFIG_STRING_VIEW
+#   if __cplusplus >= 201703L
+#       include <string_view>
+#       define CLARA_CONFIG_STRING_VIEW
+#   endif
+#endif
+
+// With CLARA_CONFIG_SEPARATE_COMPILATION the non-template machinery (tokeniser, parse loop, help
+// rendering and TextFlow) is only declared here, and defined once in the clara library (src/clara.cpp),
+// rather than in every translation unit that includes this header. The library must be built with the
+// same CLARA_CONFIG_ macros as the code that uses it
+#ifdef CLARA_CONFIG_SEPARATE_COMPILATION
+#   define CLARA_INLINE
+#else
+#   define CLARA_INLINE inline
+#endif
+
+// Only the headers that the declarations and templates need are included everywhere. The rest
+// are only needed by the definitions, so with CLARA_CONFIG_SEPARATE_COMPILATION only by the library
+#if !defined( CLARA_CONFIG_SEPARATE_COMPILATION ) || defined( CLARA_IMPLEMENTATION )
+#   include "clara_textflow.hpp"
+#   include <algorithm>
+#   include <cctype>
+#   include <mutex>
+#   include <sstream>
+#endif
 
-#include <cctype>
+#include <string>
 #include <vector>
 #include <memory>
-#include <sstream>
+#include <new>
+#include <istream>
+#include <ostream>
+#include <functional>
+#include <tuple>
 #include <cassert>
-#include <set>
-#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+#include <chrono>
+#endif
+
+#if defined( CLARA_CONFIG_PARALLEL_CONVERSION ) || defined( CLARA_CONFIG_PARALLEL_VALIDATION )
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#endif
 
 #if !defined(CLARA_PLATFORM_WINDOWS) && ( defined(WIN32) || defined(__WIN32__) || defined(_WIN32) || defined(_MSC_VER) )
 #define CLARA_PLATFORM_WINDOWS
@@ -60,11 +105,13 @@ namespace detail {
         using ReturnType = ReturnT;
     };
 
-    class TokenStream;
+    class TokenTable;
+    class CompletionIndex;
 
     // Transport for raw args (copied from main args, or supplied via init list for testing)
     class Args {
-        friend TokenStream;
+        friend TokenTable;
+        friend CompletionIndex;
         std::string m_exeName;
         std::vector<std::string> m_args;
 
@@ -78,22 +125,27 @@ namespace detail {
             m_args( args.begin()+1, args.end() )
         {}
 
-        auto exeName() const -> std::string {
+        Args( std::string exeName, std::vector<std::string> args )
+        :   m_exeName( std::move( exeName ) ),
+            m_args( std::move( args ) )
+        {}
+
+        auto exeName() const -> std::string const & {
             return m_exeName;
         }
     };
 
     // Wraps a token coming from a token stream. These may not directly correspond to strings as a single string
     // may encode an option + its argument if the : or = form is used
-    enum class TokenType {
+    enum class TokenType : std::uint8_t {
         Option, Argument
     };
     struct Token {
         TokenType type;
-        std::string token;
+        std::string const &token; // Owned by the TokenTable (or the args) the token came from
     };
 
-    inline auto isOptPrefix( char c ) -> bool {
+    constexpr auto isOptPrefix( char c ) -> bool {
         return c == '-'
 #ifdef CLARA_PLATFORM_WINDOWS
             || c == '/'
@@ -101,79 +153,364 @@ namespace detail {
         ;
     }
 
-    // Abstracts iterators into args as a stream of tokens, with option arguments uniformly handled
-    class TokenStream {
-        using Iterator = std::vector<std::string>::const_iterator;
-        Iterator it;
-        Iterator itEnd;
-        std::vector<Token> m_tokenBuffer;
+    // The short options (such as -o) that take a value, so that in a cluster of short options
+    // (getopt style) the rest of the cluster can be taken as that value - as in -j8 or -ofile
+    class ShortValueOpts {
+        std::uint64_t m_bits[4] = {};
+
+    public:
+        // Adds the option if the name is a short one
+        void add( std::string const &optName ) {
+            if( optName.size() == 2 && isOptPrefix( optName[0] ) && optName[1] != '-' ) {
+                auto c = static_cast<unsigned char>( optName[1] );
+                m_bits[c / 64] |= std::uint64_t( 1 ) << ( c % 64 );
+            }
+        }
+        auto contains( char c ) const -> bool {
+            auto uc = static_cast<unsigned char>( c );
+            return ( m_bits[uc / 64] >> ( uc % 64 ) ) & 1;
+        }
+    };
 
-        void loadBuffer() {
-            m_tokenBuffer.resize( 0 );
+    // FNV-1a hash of a name - usable at compile time
+    constexpr auto hashString( char const* name, std::uint32_t hash = 2166136261u ) -> std::uint32_t {
+        return *name == '\0'
+            ? hash
+            : hashString( name + 1, ( hash ^ static_cast<unsigned char>( *name ) ) * 16777619u );
+    }
+    inline auto hashString( char const* first, char const* last ) -> std::uint32_t {
+        std::uint32_t hash = 2166136261u;
+        for( ; first != last; ++first )
+            hash = ( hash ^ static_cast<unsigned char>( *first ) ) * 16777619u;
+        return hash;
+    }
 
-            // Skip any empty strings
-            while( it != itEnd && it->empty() )
-                ++it;
+    // Kinds of value conversion, as counted by a ParseObserver
+    enum class ConversionKind {
+        Flag, String, Bool, Integral, FloatingPoint, Choice, Lambda, Other
+    };
+    static const size_t ConversionKindCount = 8;
 
-            if( it != itEnd ) {
-                auto const &next = *it;
-                if( isOptPrefix( next[0] ) ) {
-                    auto delimiterPos = next.find_first_of( " :=" );
-                    if( delimiterPos != std::string::npos ) {
-                        m_tokenBuffer.push_back( { TokenType::Option, next.substr( 0, delimiterPos ) } );
-                        m_tokenBuffer.push_back( { TokenType::Argument, next.substr( delimiterPos + 1 ) } );
-                    } else {
-                        if( next[1] != '-' && next.size() > 2 ) {
-                            std::string opt = "- ";
-                            for( size_t i = 1; i < next.size(); ++i ) {
-                                opt[1] = next[i];
-                                m_tokenBuffer.push_back( { TokenType::Option, opt } );
-                            }
-                        } else {
-                            m_tokenBuffer.push_back( { TokenType::Option, next } );
-                        }
-                    }
-                } else {
-                    m_tokenBuffer.push_back( { TokenType::Argument, next } );
-                }
+    // Phases timed by a ParseObserver. Total covers a whole Parser::parse call,
+    // so includes the others
+    enum class ParsePhase {
+        Tokenise, Convert, Callback, Validate, Total
+    };
+    static const size_t ParsePhaseCount = 5;
+
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+
+    // Receives events from Parser::parse. Set one with Parser::observer().
+    // Only available if CLARA_CONFIG_PARSE_OBSERVER is defined - otherwise the
+    // hooks compile away to nothing
+    class ParseObserver {
+    public:
+        virtual ~ParseObserver() = default;
+
+        // The args have been split into this many tokens, copying this many bytes
+        virtual void tokensRead( size_t count, size_t bytes ) = 0;
+        // A token has been dispatched, after trying this many parsers
+        virtual void tokenDispatched( size_t parserAttempts ) = 0;
+        virtual void converted( ConversionKind kind ) = 0;
+        virtual void timed( ParsePhase phase, std::chrono::nanoseconds duration ) = 0;
+    };
+
+    struct ParseStats {
+        std::uint64_t tokensRead = 0;
+        std::uint64_t tokenBytes = 0; // Bytes copied into tokens - only args split at a delimiter are copied
+        std::uint64_t tokensDispatched = 0;
+        std::uint64_t parserAttempts = 0;
+        std::uint64_t maxParserAttemptsPerToken = 0;
+        std::uint64_t conversions[ConversionKindCount] = {};
+        std::chrono::nanoseconds times[ParsePhaseCount] = {};
+
+        auto conversionsOf( ConversionKind kind ) const -> std::uint64_t {
+            return conversions[static_cast<size_t>( kind )];
+        }
+        auto timeIn( ParsePhase phase ) const -> std::chrono::nanoseconds {
+            return times[static_cast<size_t>( phase )];
+        }
+        // Time spent in the parser loop itself
+        auto dispatchTime() const -> std::chrono::nanoseconds {
+            return timeIn( ParsePhase::Total ) - timeIn( ParsePhase::Tokenise ) - timeIn( ParsePhase::Convert ) - timeIn( ParsePhase::Callback ) - timeIn( ParsePhase::Validate );
+        }
+    };
+
+    // Accumulates events into ParseStats, across any number of parses
+    class ParseStatsObserver : public ParseObserver {
+        ParseStats m_stats;
+
+    public:
+        void tokensRead( size_t count, size_t bytes ) override {
+            m_stats.tokensRead += count;
+            m_stats.tokenBytes += bytes;
+        }
+        void tokenDispatched( size_t parserAttempts ) override {
+            ++m_stats.tokensDispatched;
+            m_stats.parserAttempts += parserAttempts;
+            if( m_stats.maxParserAttemptsPerToken < parserAttempts )
+                m_stats.maxParserAttemptsPerToken = parserAttempts;
+        }
+        void converted( ConversionKind kind ) override {
+            ++m_stats.conversions[static_cast<size_t>( kind )];
+        }
+        void timed( ParsePhase phase, std::chrono::nanoseconds duration ) override {
+            m_stats.times[static_cast<size_t>( phase )] += duration;
+        }
+
+        auto snapshot() const -> ParseStats { return m_stats; }
+        void reset() { m_stats = ParseStats(); }
+    };
+
+    class PhaseTimer {
+        ParseObserver *m_observer;
+        ParsePhase m_phase;
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        PhaseTimer( ParseObserver *observer, ParsePhase phase ) : m_observer( observer ), m_phase( phase ) {
+            if( m_observer )
+                m_start = std::chrono::steady_clock::now();
+        }
+        ~PhaseTimer() {
+            if( m_observer )
+                m_observer->timed( m_phase, std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_start ) );
+        }
+    };
+
+    inline void observeTokensRead( ParseObserver *observer, size_t count, size_t bytes ) {
+        if( observer && count != 0 )
+            observer->tokensRead( count, bytes );
+    }
+    inline void observeTokenDispatched( ParseObserver *observer, size_t parserAttempts ) {
+        if( observer )
+            observer->tokenDispatched( parserAttempts );
+    }
+
+#else // CLARA_CONFIG_PARSE_OBSERVER
+
+    class ParseObserver;
+
+    struct PhaseTimer {
+        PhaseTimer( ParseObserver *, ParsePhase ) {}
+    };
+
+    inline void observeTokensRead( ParseObserver *, size_t, size_t ) {}
+    inline void observeTokenDispatched( ParseObserver *, size_t ) {}
+
+#endif // CLARA_CONFIG_PARSE_OBSERVER
+
+    // Finds the first ' ', ':' or '=' (which separate an option from its argument), or last if there isn't one.
+    // Eight bytes are tested at a time, so long option names are scanned a word at a time
+    inline auto findOptDelimiter( char const *first, char const *last ) -> char const * {
+        std::uint64_t const ones = 0x0101010101010101ull;
+        std::uint64_t const highBits = 0x8080808080808080ull;
+        auto hasByte = [=]( std::uint64_t word, unsigned char c ) -> std::uint64_t {
+            auto x = word ^ ( ones * c );
+            return ( x - ones ) & ~x & highBits;
+        };
+        for( ; last - first >= 8; first += 8 ) {
+            std::uint64_t word;
+            std::memcpy( &word, first, sizeof( word ) );
+            if( hasByte( word, ' ' ) | hasByte( word, ':' ) | hasByte( word, '=' ) )
+                break;
+        }
+        for( ; first != last; ++first ) {
+            if( *first == ' ' || *first == ':' || *first == '=' )
+                break;
+        }
+        return first;
+    }
+
+    // "-c" for every char c, so that the tokens of a short option cluster can refer to their names without copying
+    inline auto shortOptName( char c ) -> std::string const & {
+        struct Names {
+            std::string names[256];
+            Names() {
+                for( int i = 0; i < 256; ++i )
+                    names[i] = { '-', static_cast<char>( i ) };
             }
+        };
+        static Names const names;
+        return names.names[static_cast<unsigned char>( c )];
+    }
+
+    // All the args of a parse, classified into tokens in one pass before parsing starts.
+    // Each token is a slice (offset and length) of one arg, its source. The columns are stored
+    // apart (struct of arrays), inline for short command lines. A token that is a whole arg refers
+    // to the arg itself, and a short option from a cluster to a shared name, so only args split
+    // at a delimiter (--opt=value, or -ofile for a short option that takes a value) are copied.
+    // A table can be refilled for another parse, reusing its storage
+    class TokenTable {
+        static const size_t InlineTokens = 24;
+        static const size_t BytesPerToken = sizeof( std::string const * ) + 3 * sizeof( std::uint32_t ) + sizeof( TokenType );
+
+        std::vector<std::string> const *m_args = nullptr;
+        size_t m_size = 0;
+        size_t m_endOfOptions = size_t( -1 ); // The first token after "--", if there is one
+        alignas( std::string const * ) unsigned char m_inlineColumns[InlineTokens * BytesPerToken];
+        std::unique_ptr<unsigned char[]> m_heapColumns;
+        size_t m_heapCapacity = 0; // In tokens
+        std::string const **m_texts = nullptr;
+        std::uint32_t *m_sources = nullptr;
+        std::uint32_t *m_offsets = nullptr;
+        std::uint32_t *m_lengths = nullptr;
+        TokenType *m_types = nullptr;
+        std::vector<std::string> m_slices; // Reserved up front, so the texts can point into it
+        size_t m_sliceCount = 0;
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+        ParseObserver *m_observer = nullptr;
+#endif
+
+        // Calls addToken( type, source, offset, length ) for each token in order, and returns the
+        // number of tokens before "--" (or -1 if there is no "--"). Empty args make no tokens
+        template<typename F>
+        auto classify( ShortValueOpts const &shortValueOpts, F const &addToken ) const -> size_t;
+
+        static auto isCopied( TokenType type, std::string const &arg, size_t offset, size_t length ) -> bool {
+            return ( offset != 0 || length != arg.size() ) && ( type == TokenType::Argument || offset == 0 );
         }
 
+        void allocateColumns();
+
+        // Copies a slice of an arg, into the string left from a previous fill if there is one
+        auto copySlice( std::string const &arg, size_t offset, size_t length ) -> std::string const &;
+
     public:
-        explicit TokenStream( Args const &args ) : TokenStream( args.m_args.begin(), args.m_args.end() ) {}
+        // An empty table, to be filled later
+        TokenTable() = default;
+
+        TokenTable( Args const &args, ShortValueOpts const &shortValueOpts, ParseObserver *observer = nullptr ) {
+            fill( args, shortValueOpts, observer );
+        }
+
+        // Tokenises these args in place of any from before
+        void fill( Args const &args, ShortValueOpts const &shortValueOpts, ParseObserver *observer = nullptr );
 
-        TokenStream( Iterator it, Iterator itEnd ) : it( it ), itEnd( itEnd ) {
-            loadBuffer();
+        TokenTable( TokenTable const & ) = delete;
+        auto operator=( TokenTable const & ) -> TokenTable & = delete;
+
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+        auto observer() const -> ParseObserver * { return m_observer; }
+#else
+        auto observer() const -> ParseObserver * { return nullptr; }
+#endif
+
+        auto args() const -> std::vector<std::string> const & { return *m_args; }
+        auto size() const -> size_t { return m_size; }
+        auto endOfOptions() const -> size_t { return m_endOfOptions; }
+
+        auto type( size_t index ) const -> TokenType { return m_types[index]; }
+        auto text( size_t index ) const -> std::string const & { return *m_texts[index]; }
+        auto source( size_t index ) const -> size_t { return m_sources[index]; }
+        auto isWholeArg( size_t index ) const -> bool {
+            return m_offsets[index] == 0 && m_lengths[index] == (*m_args)[m_sources[index]].size();
+        }
+
+        // The first token from this arg, or a later one
+        auto firstTokenFrom( size_t source ) const -> size_t;
+    };
+
+    // Abstracts args as a stream of tokens, with option arguments uniformly handled.
+    // The stream is a cursor - an index into a TokenTable - so parsers pass it around by value,
+    // and copying it (to backtrack, or into a ParseState) costs nothing
+    class TokenStream {
+        using Iterator = std::vector<std::string>::const_iterator;
+        TokenTable const *m_table = nullptr;
+        size_t m_index = 0;
+        bool m_batched = true; // Whether runs of arguments may be consumed in bulk
+
+        struct TokenPointer {
+            Token token;
+            auto operator->() const -> Token const * { return &token; }
+        };
+
+        auto argAt( size_t index ) const -> Iterator {
+            return m_table->args().begin() + static_cast<std::ptrdiff_t>( m_table->source( index ) );
         }
 
+    public:
+        // An empty stream
+        TokenStream() = default;
+
+        // Streams a table that must outlive the stream (and its copies)
+        explicit TokenStream( TokenTable const &table ) : m_table( &table ) {}
+
+        auto observer() const -> ParseObserver * { return m_table ? m_table->observer() : nullptr; }
+
         explicit operator bool() const {
-            return !m_tokenBuffer.empty() || it != itEnd;
+            return m_table && m_index < m_table->size();
+        }
+
+        auto count() const -> size_t { return m_table ? m_table->size() - m_index : 0; }
+
+        // The position of the current token in the table, and of the raw arg it came from in argv
+        // (so counting the exe name). Both are one past the end once the stream is exhausted
+        auto index() const -> size_t { return m_index; }
+        auto argIndex() const -> size_t {
+            if( !m_table )
+                return 1;
+            return 1 + ( *this ? m_table->source( m_index ) : m_table->args().size() );
         }
 
-        auto count() const -> size_t { return m_tokenBuffer.size() + (itEnd - it); }
+        // A copy whose argument runs are always empty, so every token is parsed on its own
+        auto unbatched() const -> TokenStream {
+            auto tokens = *this;
+            tokens.m_batched = false;
+            return tokens;
+        }
 
         auto operator*() const -> Token {
-            assert( !m_tokenBuffer.empty() );
-            return m_tokenBuffer.front();
+            assert( *this );
+            return { m_table->type( m_index ), m_table->text( m_index ) };
         }
 
-        auto operator->() const -> Token const * {
-            assert( !m_tokenBuffer.empty() );
-            return &m_tokenBuffer.front();
+        auto operator->() const -> TokenPointer {
+            return { **this };
         }
 
         auto operator++() -> TokenStream & {
-            if( m_tokenBuffer.size() >= 2 ) {
-                m_tokenBuffer.erase( m_tokenBuffer.begin() );
-            } else {
-                if( it != itEnd )
-                    ++it;
-                loadBuffer();
-            }
+            ++m_index;
+            return *this;
+        }
+
+        // Once past the "--" marker every remaining raw arg is exactly one argument token,
+        // so they can be consumed in bulk, by-passing the token table
+        auto isPastEndOfOptions() const -> bool { return m_table && m_index >= m_table->endOfOptions(); }
+
+        auto remainingArgsBegin() const -> Iterator {
+            assert( isPastEndOfOptions() && *this );
+            return argAt( m_index );
+        }
+        auto remainingArgsEnd() const -> Iterator { return m_table->args().end(); }
+
+        // The run of raw args, from the current one, that each make exactly one argument token,
+        // so can also be consumed in bulk. The run is empty if the current token came from splitting an arg.
+        // Any empty args within the run are left for the consumer to skip
+        auto argumentRunBegin() const -> Iterator { return argAt( m_index ); }
+        auto argumentRunEnd() const -> Iterator {
+            auto end = m_index;
+            while( m_batched
+                    && end < m_table->size()
+                    && m_table->type( end ) == TokenType::Argument
+                    && m_table->isWholeArg( end )
+                    && ( end != m_table->endOfOptions() || end == m_index ) )
+                ++end;
+            return end == m_index ? argAt( m_index ) : argAt( end - 1 ) + 1;
+        }
+
+        // Moves on to a raw arg from the current run
+        auto skipTo( Iterator pos ) -> TokenStream & {
+            m_index = m_table->firstTokenFrom( size_t( pos - m_table->args().begin() ) );
             return *this;
         }
-    };
 
+        auto skipRemaining() -> TokenStream & {
+            m_index = m_table ? m_table->size() : 0;
+            return *this;
+        }
+    };
+    static_assert( std::is_trivially_copyable<TokenStream>::value, "TokenStream must stay a plain cursor" );
 
     class ResultBase {
     public:
@@ -210,6 +547,10 @@ namespace detail {
             new( &m_value ) T( value );
         }
 
+        ResultValueBase( Type, T &&value ) : ResultBase( Ok ) {
+            new( &m_value ) T( std::move( value ) );
+        }
+
         auto operator=( ResultValueBase const &other ) -> ResultValueBase & {
             if( m_type == ResultBase::Ok )
                 m_value.~T();
@@ -248,6 +589,9 @@ namespace detail {
 
         template<typename U>
         static auto ok( U const &value ) -> BasicResult { return { ResultBase::Ok, value }; }
+        // Moves the value in, rather than copying it
+        template<typename U, typename = typename std::enable_if<std::is_same<U, T>::value>::type>
+        static auto ok( U &&value ) -> BasicResult { return { ResultBase::Ok, std::move( value ) }; }
         static auto ok() -> BasicResult { return { ResultBase::Ok }; }
         static auto logicError( std::string const &message ) -> BasicResult { return { ResultBase::LogicError, message }; }
         static auto runtimeError( std::string const &message ) -> BasicResult { return { ResultBase::RuntimeError, message }; }
@@ -293,7 +637,7 @@ namespace detail {
         {}
 
         auto type() const -> ParseResultType { return m_type; }
-        auto remainingTokens() const -> TokenStream { return m_remainingTokens; }
+        auto remainingTokens() const -> TokenStream const & { return m_remainingTokens; }
 
     private:
         ParseResultType m_type;
@@ -304,36 +648,58 @@ namespace detail {
     using ParserResult = BasicResult<ParseResultType>;
     using InternalParseResult = BasicResult<ParseState>;
 
+    // The remaining tokens of a finished parse index into a TokenTable that is about to go,
+    // so the result is handed back without them
+    inline auto detachTokens( InternalParseResult const &result ) -> InternalParseResult {
+        if( !result )
+            return result;
+        return InternalParseResult::ok( ParseState( result.value().type(), TokenStream() ) );
+    }
+
+    enum class DiagnosticKind {
+        UnrecognisedToken, ConversionFailed, MissingArgument, MissingRequired, ConstraintViolated, ValidationFailed
+    };
+
+    // An error found by Parser::parseCollectingErrors
+    struct Diagnostic {
+        DiagnosticKind kind;
+        size_t token; // The token at fault, counting from 0 - or the number of tokens, for MissingRequired and ConstraintViolated
+        size_t arg;   // The index in argv of the arg the token came from - or argc, for MissingRequired and ConstraintViolated
+        std::string message;
+    };
+    using DiagnosticsResult = BasicResult<std::vector<Diagnostic>>;
+
+    // Splits a command line held in one string into Args, as a POSIX shell splits it into words: at unquoted
+    // whitespace, with single quotes, double quotes and backslash escapes, but without any expansions.
+    // The first word is the exe name. Words with no quotes or escapes are copied straight out of the
+    // command line - only the others are unescaped, through a scratch buffer
+    auto splitCommandLine( std::string const &commandLine ) -> BasicResult<Args>;
+
     struct HelpColumns {
         std::string left;
         std::string right;
     };
 
+    // Lays out the rows of option help in two columns, the left sized to fit (up to half the console)
+    void writeHelpRows( std::ostream &os, std::vector<HelpColumns> const &rows );
+
+    // Conversions through a stream share one (non-template) function, so each type converted
+    // that way only adds its operator>> call
+    template<typename T>
+    void extractFromStream( std::istream &is, void *target ) {
+        is >> *static_cast<T *>( target );
+    }
+    auto convertByStream( std::string const &source, void *target, void ( *extract )( std::istream &, void * ) ) -> ParserResult;
+
     template<typename T>
     inline auto convertInto( std::string const &source, T& target ) -> ParserResult {
-        std::stringstream ss;
-        ss << source;
-        ss >> target;
-        if( ss.fail() )
-            return ParserResult::runtimeError( "Unable to convert '" + source + "' to destination type" );
-        else
-            return ParserResult::ok( ParseResultType::Matched );
+        return convertByStream( source, &target, &extractFromStream<T> );
     }
     inline auto convertInto( std::string const &source, std::string& target ) -> ParserResult {
         target = source;
         return ParserResult::ok( ParseResultType::Matched );
     }
-    inline auto convertInto( std::string const &source, bool &target ) -> ParserResult {
-        std::string srcLC = source;
-        std::transform( srcLC.begin(), srcLC.end(), srcLC.begin(), []( char c ) { return static_cast<char>( std::tolower(c) ); } );
-        if (srcLC == "y" || srcLC == "1" || srcLC == "true" || srcLC == "yes" || srcLC == "on")
-            target = true;
-        else if (srcLC == "n" || srcLC == "0" || srcLC == "false" || srcLC == "no" || srcLC == "off")
-            target = false;
-        else
-            return ParserResult::runtimeError( "Expected a boolean value but did not recognise: '" + source + "'" );
-        return ParserResult::ok( ParseResultType::Matched );
-    }
+    auto convertInto( std::string const &source, bool &target ) -> ParserResult;
 #ifdef CLARA_CONFIG_OPTIONAL_TYPE
     template<typename T>
     inline auto convertInto( std::string const &source, CLARA_CONFIG_OPTIONAL_TYPE<T>& target ) -> ParserResult {
@@ -345,6 +711,192 @@ namespace detail {
     }
 #endif // CLARA_CONFIG_OPTIONAL_TYPE
 
+    // Conversions from a range within a larger string (an element of a delimited list).
+    // Integers are converted in place; other types go via a scratch string that is
+    // reused across elements, so only grows (and allocates) when an element is longer
+    template<typename T>
+    struct IsIntegralNumber : std::integral_constant<bool,
+            std::is_integral<T>::value &&
+            !std::is_same<T, bool>::value &&
+            !std::is_same<T, char>::value &&
+            !std::is_same<T, signed char>::value &&
+            !std::is_same<T, unsigned char>::value &&
+            !std::is_same<T, wchar_t>::value &&
+            !std::is_same<T, char16_t>::value &&
+            !std::is_same<T, char32_t>::value> {};
+
+    template<typename T>
+    inline auto convertInto( char const *first, char const *last, std::string &scratch, T &target )
+        -> typename std::enable_if<!IsIntegralNumber<T>::value, ParserResult>::type {
+        scratch.assign( first, last );
+        return convertInto( scratch, target );
+    }
+    inline auto convertInto( char const *first, char const *last, std::string &, std::string &target ) -> ParserResult {
+        target.assign( first, last );
+        return ParserResult::ok( ParseResultType::Matched );
+    }
+    // Parses a decimal integer, with an optional sign, into its magnitude. max is the largest value
+    // of the type being converted to - a negative value of a signed type may be one more
+    auto parseInteger( char const *first, char const *last, bool isSigned, std::uint64_t max, std::uint64_t &magnitude, bool &negative ) -> ParserResult;
+
+    template<typename T>
+    inline auto convertInto( char const *first, char const *last, std::string &, T &target )
+        -> typename std::enable_if<IsIntegralNumber<T>::value, ParserResult>::type {
+        static_assert( sizeof( T ) <= sizeof( std::uint64_t ), "Integers are parsed through 64 bits" );
+        using UnsignedT = typename std::make_unsigned<T>::type;
+
+        std::uint64_t magnitude = 0;
+        bool negative = false;
+        auto result = parseInteger( first, last, std::is_signed<T>::value, static_cast<std::uint64_t>( (std::numeric_limits<T>::max)() ), magnitude, negative );
+        if( result ) {
+            auto value = static_cast<UnsignedT>( magnitude );
+            target = ( negative && value != 0 )
+                ? static_cast<T>( -static_cast<T>( value - 1 ) - 1 )
+                : static_cast<T>( value );
+        }
+        return result;
+    }
+
+    // Calls setElement( first, last ) for each element of a delimited list, stopping at the first failure.
+    // The delimiters are found with memchr, which the standard libraries vectorise
+    template<typename F>
+    inline auto forEachDelimited( std::string const &arg, char delimiter, F const &setElement ) -> ParserResult {
+        if( arg.empty() )
+            return ParserResult::ok( ParseResultType::Matched );
+
+        auto first = arg.data();
+        auto const end = first + arg.size();
+        for( size_t index = 0;; ++index ) {
+            auto last = static_cast<char const *>( std::memchr( first, delimiter, static_cast<size_t>( end - first ) ) );
+            if( !last )
+                last = end;
+
+            ParserResult result = setElement( first, last );
+            if( !result ) {
+                auto message = result.errorMessage() + " (at list index " + std::to_string( index ) + ")";
+                return result.type() == ResultBase::LogicError
+                    ? ParserResult::logicError( message )
+                    : ParserResult::runtimeError( message );
+            }
+            if( result.value() == ParseResultType::ShortCircuitAll || last == end )
+                return result;
+            first = last + 1;
+        }
+    }
+
+    // A fixed set of named values that an Opt or Arg can be restricted to - e.g. for enums.
+    // The names are hashed into an open addressed table once, when the Choices are created,
+    // so each conversion is a single hash and (usually) one string compare.
+    // Copies share the same table
+    template<typename T>
+    class Choices {
+        struct Entry {
+            std::string name;
+            T value;
+            std::uint32_t hash;
+        };
+        struct Table {
+            std::vector<Entry> entries; // In declaration order, for help
+            std::vector<std::uint32_t> slots; // Entry index + 1, or 0 if empty
+            std::string duplicate;
+        };
+        std::shared_ptr<Table> m_table;
+
+        void add( std::string const &name, T const &value ) {
+            m_table->entries.push_back( { name, value, hashString( name.data(), name.data() + name.size() ) } );
+        }
+
+        void buildSlots() {
+            auto &table = *m_table;
+            size_t size = 8;
+            while( size < table.entries.size() * 2 )
+                size *= 2;
+            table.slots.assign( size, 0 );
+            for( size_t i = 0; i < table.entries.size(); ++i ) {
+                auto const &entry = table.entries[i];
+                auto slot = entry.hash & ( size - 1 );
+                for( ; table.slots[slot] != 0; slot = ( slot + 1 ) & ( size - 1 ) ) {
+                    if( table.duplicate.empty() && table.entries[table.slots[slot] - 1].name == entry.name )
+                        table.duplicate = entry.name;
+                }
+                table.slots[slot] = static_cast<std::uint32_t>( i + 1 );
+            }
+        }
+
+    public:
+        Choices( std::initializer_list<std::pair<std::string, T>> choices )
+        :   m_table( std::make_shared<Table>() )
+        {
+            m_table->entries.reserve( choices.size() );
+            for( auto const &choice : choices )
+                add( choice.first, choice.second );
+            buildSlots();
+        }
+
+        // For restricting strings, the names can be given on their own
+        template<typename U = T, typename = typename std::enable_if<std::is_same<U, std::string>::value>::type>
+        Choices( std::initializer_list<std::string> names ) : Choices( std::vector<std::string>( names ) ) {}
+
+        template<typename U = T, typename = typename std::enable_if<std::is_same<U, std::string>::value>::type>
+        explicit Choices( std::vector<std::string> const &names )
+        :   m_table( std::make_shared<Table>() )
+        {
+            m_table->entries.reserve( names.size() );
+            for( auto const &name : names )
+                add( name, name );
+            buildSlots();
+        }
+
+        auto find( std::string const &name ) const -> T const * {
+            auto const &table = *m_table;
+            auto hash = hashString( name.data(), name.data() + name.size() );
+            auto mask = table.slots.size() - 1;
+            for( auto slot = hash & mask; table.slots[slot] != 0; slot = ( slot + 1 ) & mask ) {
+                auto const &entry = table.entries[table.slots[slot] - 1];
+                if( entry.hash == hash && entry.name == name )
+                    return &entry.value;
+            }
+            return nullptr;
+        }
+
+        auto convertInto( std::string const &source, T &target ) const -> ParserResult {
+            if( auto value = find( source ) ) {
+                target = *value;
+                return ParserResult::ok( ParseResultType::Matched );
+            }
+            return ParserResult::runtimeError( "'" + source + "' is not one of the valid choices" );
+        }
+
+        auto validate() const -> Result {
+            if( m_table->entries.empty() )
+                return Result::logicError( "No choices supplied" );
+            if( !m_table->duplicate.empty() )
+                return Result::logicError( "Choice names must be unique, but '" + m_table->duplicate + "' is repeated" );
+            return Result::ok();
+        }
+
+        auto names() const -> std::vector<std::string> {
+            std::vector<std::string> names;
+            names.reserve( m_table->entries.size() );
+            for( auto const &entry : m_table->entries )
+                names.push_back( entry.name );
+            return names;
+        }
+
+        auto describe() const -> std::string {
+            std::string description = "one of: ";
+            bool first = true;
+            for( auto const &entry : m_table->entries ) {
+                if( first )
+                    first = false;
+                else
+                    description += ", ";
+                description += entry.name;
+            }
+            return description;
+        }
+    };
+
     struct NonCopyable {
         NonCopyable() = default;
         NonCopyable( NonCopyable const & ) = delete;
@@ -353,60 +905,395 @@ namespace detail {
         NonCopyable &operator=( NonCopyable && ) = delete;
     };
 
+    template<typename T>
+    constexpr auto conversionKindOf() -> ConversionKind {
+        return std::is_same<T, std::string>::value ? ConversionKind::String
+             : std::is_same<T, bool>::value ? ConversionKind::Bool
+             : IsIntegralNumber<T>::value ? ConversionKind::Integral
+             : std::is_floating_point<T>::value ? ConversionKind::FloatingPoint
+             : ConversionKind::Other;
+    }
+
+    // Puts a bound variable back to the value it had when this was captured
+    struct BoundDefault {
+        virtual ~BoundDefault() = default;
+        virtual void restore() = 0;
+    };
+
+    template<typename T>
+    struct BoundDefaultValue : BoundDefault {
+        T &m_ref;
+        T m_default;
+
+        explicit BoundDefaultValue( T &ref ) : m_ref( ref ), m_default( ref ) {}
+
+        // Assigning, rather than swapping in a copy, lets strings and containers keep their capacity
+        void restore() override { m_ref = m_default; }
+    };
+
     struct BoundRef : NonCopyable {
         virtual ~BoundRef() = default;
         virtual auto isContainer() const -> bool { return false; }
         virtual auto isFlag() const -> bool { return false; }
+        virtual auto validate() const -> Result { return Result::ok(); }
+
+        // Any restrictions on the values accepted, for help
+        virtual auto describeValues() const -> std::string { return {}; }
+
+        // The names of the values accepted, if restricted, for completion
+        virtual auto valueNames() const -> std::vector<std::string> { return {}; }
+
+        virtual auto conversionKind() const -> ConversionKind { return ConversionKind::Other; }
+
+        // The current value of the bound variable, to be restored later. Null if there isn't one (for lambdas)
+        virtual auto captureDefault() const -> std::shared_ptr<BoundDefault> { return {}; }
     };
     struct BoundValueRefBase : BoundRef {
+        using ArgIterator = std::vector<std::string>::const_iterator;
+
         virtual auto setValue( std::string const &arg ) -> ParserResult = 0;
+
+        // Sets each (non-empty) arg in turn, stopping at the first failure
+        virtual auto setValues( ArgIterator first, ArgIterator last ) -> ParserResult {
+            for( ; first != last; ++first ) {
+                if( first->empty() )
+                    continue;
+                auto result = setValue( *first );
+                if( !result )
+                    return result;
+            }
+            return ParserResult::ok( ParseResultType::Matched );
+        }
+
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+        // As setValues, but converting on up to this many threads (0 for one per core). Only containers do
+        virtual auto setValuesInParallel( ArgIterator first, ArgIterator last, size_t ) -> ParserResult {
+            return setValues( first, last );
+        }
+#endif
+
+        // Sets each element of a delimited list in turn
+        virtual auto setDelimitedValues( std::string const &arg, char delimiter ) -> ParserResult {
+            std::string element;
+            return forEachDelimited( arg, delimiter, [&]( char const *first, char const *last ) -> ParserResult {
+                element.assign( first, last );
+                return setValue( element );
+            } );
+        }
+
+        // Hint that up to this many more values may be set (only used by containers)
+        virtual void reserve( size_t ) {}
     };
     struct BoundFlagRefBase : BoundRef {
         virtual auto setFlag( bool flag ) -> ParserResult = 0;
         virtual auto isFlag() const -> bool { return true; }
+        auto conversionKind() const -> ConversionKind override { return ConversionKind::Flag; }
     };
 
+} // namespace detail
+
+    // Describes how values are added to a bound container. Other containers can be
+    // supported by specialising clara::ContainerTraits with isContainer = true, a ValueType,
+    // an add() function and a reserve() function that makes room for up to n more values
     template<typename T>
-    struct BoundValueRef : BoundValueRefBase {
-        T &m_ref;
+    struct ContainerTraits {
+        static const bool isContainer = false;
+    };
+
+namespace detail {
 
-        explicit BoundValueRef( T &ref ) : m_ref( ref ) {}
+    template<typename ContainerT>
+    struct SequenceContainerTraits {
+        static const bool isContainer = true;
+        using ValueType = typename ContainerT::value_type;
 
-        auto setValue( std::string const &arg ) -> ParserResult override {
-            return convertInto( arg, m_ref );
+        static void add( ContainerT &container, ValueType &&value ) {
+            container.push_back( std::move( value ) );
         }
+        static void reserve( ContainerT &, size_t ) {}
     };
 
-    template<typename T>
-    struct BoundValueRef<std::vector<T>> : BoundValueRefBase {
-        std::vector<T> &m_ref;
-
-        explicit BoundValueRef( std::vector<T> &ref ) : m_ref( ref ) {}
+    template<typename ContainerT>
+    struct SetContainerTraits {
+        static const bool isContainer = true;
+        using ValueType = typename ContainerT::value_type;
 
-        auto isContainer() const -> bool override { return true; }
-
-        auto setValue( std::string const &arg ) -> ParserResult override {
-            T temp;
-            auto result = convertInto( arg, temp );
-            if( result )
-                m_ref.push_back( temp );
-            return result;
+        // Duplicate values are dropped
+        static void add( ContainerT &container, ValueType &&value ) {
+            container.insert( std::move( value ) );
         }
+        static void reserve( ContainerT &, size_t ) {}
     };
 
-    struct BoundFlagRef : BoundFlagRefBase {
-        bool &m_ref;
-
-        explicit BoundFlagRef( bool &ref ) : m_ref( ref ) {}
+} // namespace detail
 
-        auto setFlag( bool flag ) -> ParserResult override {
-            m_ref = flag;
-            return ParserResult::ok( ParseResultType::Matched );
+    // std::deque, std::set and std::unordered_set are supported by clara_containers.hpp - which this header
+    // includes, unless CLARA_CONFIG_SEPARATE_COMPILATION is defined, when code that binds them includes it
+    template<typename T, typename AllocatorT>
+    struct ContainerTraits<std::vector<T, AllocatorT>> : detail::SequenceContainerTraits<std::vector<T, AllocatorT>> {
+        // Grows at least geometrically, so that reserving for each of many options in turn stays linear
+        static void reserve( std::vector<T, AllocatorT> &container, size_t additional ) {
+            if( container.capacity() < container.size() + additional )
+                container.reserve( container.size() + additional > container.capacity() * 2 ? container.size() + additional : container.capacity() * 2 );
         }
     };
 
-    template<typename ReturnType>
-    struct LambdaInvoker {
+namespace detail {
+
+    // The typed operations on a bound variable (or container). There is one static table of these
+    // per type bound, shared by every binding to a variable of that type, so each type adds only
+    // these few small functions - rather than a class, with its own vtable, per type
+    struct ValueOps {
+        ConversionKind kind;
+        bool isContainer;
+
+        // Converts the arg into the variable - or, for a container, into an element that is added to it
+        auto ( *setValue )( void *target, std::string const &arg ) -> ParserResult;
+        auto ( *captureDefault )( void *target ) -> std::shared_ptr<BoundDefault>;
+
+        // Only for containers: setValue for an element of a delimited list (reusing the scratch
+        // string across elements), and reserving space for more elements
+        auto ( *setRange )( void *target, char const *first, char const *last, std::string &scratch ) -> ParserResult;
+        void ( *reserve )( void *target, size_t additional );
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+        auto ( *setValuesInParallel )( void *target, std::vector<std::string const *> const &args, size_t threads ) -> ParserResult;
+#endif
+    };
+
+#if defined( CLARA_CONFIG_PARALLEL_CONVERSION ) || defined( CLARA_CONFIG_PARALLEL_VALIDATION )
+    // The worker threads shared by every parse, started as they are first needed and joined at exit.
+    // run( threads, task ) calls task on the calling thread and on up to threads - 1 workers at once,
+    // so task should claim work (with an atomic counter, say) until there is none left. It returns
+    // once every call of task that started has finished, rethrowing an exception thrown by any of them.
+    // Jobs never run on more threads than maxThreads(), so the pool never grows past one worker per core
+    class WorkerPool {
+        struct Job {
+            std::function<void()> const &task;
+            size_t running;
+            std::exception_ptr exception;
+        };
+        std::mutex m_mutex;
+        std::condition_variable m_wake;     // For the workers, when tickets are queued
+        std::condition_variable m_finished; // For the callers of run, when their tickets finish
+        std::deque<Job *> m_tickets;        // One per worker wanted by each job
+        std::vector<std::thread> m_workers;
+        bool m_stopping = false;
+
+        WorkerPool() = default;
+
+        void work();
+
+        // Drops the job's tickets that no worker has taken, and waits for the rest
+        void finish( Job &job );
+
+    public:
+        WorkerPool( WorkerPool const & ) = delete;
+        auto operator=( WorkerPool const & ) -> WorkerPool & = delete;
+        ~WorkerPool();
+
+        static auto instance() -> WorkerPool &;
+
+        // One per core, or a few if the number of cores is not known
+        static auto maxThreads() -> size_t {
+            auto cores = std::thread::hardware_concurrency();
+            return cores != 0 ? cores : 4;
+        }
+
+        auto workerCount() -> size_t {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            return m_workers.size();
+        }
+
+        void run( size_t threads, std::function<void()> const &task );
+    };
+#endif
+
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+    struct ParallelConversion {
+        size_t converted; // Before the first failure, if there was one
+        ParserResult result;
+    };
+
+    // Calls convert( *args[i], values, i ) for each arg, in chunks claimed in turn by each of up to this many
+    // threads of the WorkerPool (0 for one per core). A chunk stops at its first failure (or exception) and
+    // chunks after the earliest failing chunk are skipped, so the error reported (and the values converted
+    // before it) are the same as in order
+    auto convertInParallel( std::vector<std::string const *> const &args, size_t threads, void *values,
+                            auto ( *convert )( std::string const &arg, void *values, size_t index ) -> ParserResult ) -> ParallelConversion;
+#endif
+
+    template<typename T, bool = ContainerTraits<T>::isContainer>
+    struct ValueOpsFor {
+        static auto setValue( void *target, std::string const &arg ) -> ParserResult {
+            return convertInto( arg, *static_cast<T *>( target ) );
+        }
+        static auto captureDefault( void *target ) -> std::shared_ptr<BoundDefault> {
+            return std::make_shared<BoundDefaultValue<T>>( *static_cast<T *>( target ) );
+        }
+
+        static auto ops() -> ValueOps const & {
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+            static ValueOps const ops = { conversionKindOf<T>(), false, &setValue, &captureDefault, nullptr, nullptr, nullptr };
+#else
+            static ValueOps const ops = { conversionKindOf<T>(), false, &setValue, &captureDefault, nullptr, nullptr };
+#endif
+            return ops;
+        }
+    };
+
+    template<typename T>
+    struct ValueOpsFor<T, true> {
+        using Traits = ContainerTraits<T>;
+        using ValueType = typename Traits::ValueType;
+
+        static auto setValue( void *target, std::string const &arg ) -> ParserResult {
+            ValueType temp;
+            auto result = convertInto( arg, temp );
+            if( result )
+                Traits::add( *static_cast<T *>( target ), std::move( temp ) );
+            return result;
+        }
+        static auto captureDefault( void *target ) -> std::shared_ptr<BoundDefault> {
+            return std::make_shared<BoundDefaultValue<T>>( *static_cast<T *>( target ) );
+        }
+        static auto setRange( void *target, char const *first, char const *last, std::string &scratch ) -> ParserResult {
+            ValueType temp;
+            auto result = convertInto( first, last, scratch, temp );
+            if( result )
+                Traits::add( *static_cast<T *>( target ), std::move( temp ) );
+            return result;
+        }
+        static void reserve( void *target, size_t additional ) {
+            Traits::reserve( *static_cast<T *>( target ), additional );
+        }
+
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+        // Converts into a temporary array, then adds the values in order
+        static auto setValuesInParallel( void *target, std::vector<std::string const *> const &args, size_t threads ) -> ParserResult {
+            std::unique_ptr<ValueType[]> values( new ValueType[args.size()] );
+            auto conversion = convertInParallel( args, threads, values.get(), []( std::string const &arg, void *values, size_t index ) {
+                return convertInto( arg, static_cast<ValueType *>( values )[index] );
+            } );
+            auto &container = *static_cast<T *>( target );
+            Traits::reserve( container, conversion.converted );
+            for( size_t i = 0; i < conversion.converted; ++i )
+                Traits::add( container, std::move( values[i] ) );
+            return conversion.result;
+        }
+#endif
+
+        static auto ops() -> ValueOps const & {
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+            static ValueOps const ops = { conversionKindOf<ValueType>(), true, &setValue, &captureDefault, &setRange, &reserve, &setValuesInParallel };
+#else
+            static ValueOps const ops = { conversionKindOf<ValueType>(), true, &setValue, &captureDefault, &setRange, &reserve };
+#endif
+            return ops;
+        }
+    };
+
+    // Binds to a variable (or container) through the ValueOps for its type
+    class BoundValue : public BoundValueRefBase {
+        void *m_target;
+        ValueOps const &m_ops;
+
+    public:
+        BoundValue( void *target, ValueOps const &ops ) : m_target( target ), m_ops( ops ) {}
+
+        auto isContainer() const -> bool override { return m_ops.isContainer; }
+        auto conversionKind() const -> ConversionKind override { return m_ops.kind; }
+        auto captureDefault() const -> std::shared_ptr<BoundDefault> override { return m_ops.captureDefault( m_target ); }
+
+        auto setValue( std::string const &arg ) -> ParserResult override { return m_ops.setValue( m_target, arg ); }
+        auto setValues( ArgIterator first, ArgIterator last ) -> ParserResult override;
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+        auto setValuesInParallel( ArgIterator first, ArgIterator last, size_t threads ) -> ParserResult override;
+#endif
+        auto setDelimitedValues( std::string const &arg, char delimiter ) -> ParserResult override;
+        void reserve( size_t additional ) override;
+    };
+
+    template<typename T>
+    auto makeBoundValue( T &ref ) -> std::shared_ptr<BoundValueRefBase> {
+        return std::make_shared<BoundValue>( &ref, ValueOpsFor<T>::ops() );
+    }
+
+    // Binds to a variable (or container) that only accepts values from a set of Choices
+    template<typename T, typename ValueT, bool = ContainerTraits<T>::isContainer>
+    struct BoundChoiceRef : BoundValueRefBase {
+        T &m_ref;
+        Choices<ValueT> m_choices;
+
+        BoundChoiceRef( T &ref, Choices<ValueT> const &choices ) : m_ref( ref ), m_choices( choices ) {}
+
+        auto setValue( std::string const &arg ) -> ParserResult override {
+            return m_choices.convertInto( arg, m_ref );
+        }
+        auto validate() const -> Result override { return m_choices.validate(); }
+        auto describeValues() const -> std::string override { return m_choices.describe(); }
+        auto valueNames() const -> std::vector<std::string> override { return m_choices.names(); }
+        auto conversionKind() const -> ConversionKind override { return ConversionKind::Choice; }
+        auto captureDefault() const -> std::shared_ptr<BoundDefault> override {
+            return std::make_shared<BoundDefaultValue<T>>( m_ref );
+        }
+    };
+
+    template<typename T, typename ValueT>
+    struct BoundChoiceRef<T, ValueT, true> : BoundValueRefBase {
+        using Traits = ContainerTraits<T>;
+        T &m_ref;
+        Choices<ValueT> m_choices;
+
+        BoundChoiceRef( T &ref, Choices<ValueT> const &choices ) : m_ref( ref ), m_choices( choices ) {}
+
+        auto isContainer() const -> bool override { return true; }
+
+        auto setValue( std::string const &arg ) -> ParserResult override {
+            ValueT temp{};
+            auto result = m_choices.convertInto( arg, temp );
+            if( result )
+                Traits::add( m_ref, std::move( temp ) );
+            return result;
+        }
+        void reserve( size_t additional ) override {
+            Traits::reserve( m_ref, additional );
+        }
+        auto validate() const -> Result override { return m_choices.validate(); }
+        auto describeValues() const -> std::string override { return m_choices.describe(); }
+        auto valueNames() const -> std::vector<std::string> override { return m_choices.names(); }
+        auto conversionKind() const -> ConversionKind override { return ConversionKind::Choice; }
+        auto captureDefault() const -> std::shared_ptr<BoundDefault> override {
+            return std::make_shared<BoundDefaultValue<T>>( m_ref );
+        }
+    };
+
+    struct BoundFlagRef : BoundFlagRefBase {
+        bool &m_ref;
+
+        explicit BoundFlagRef( bool &ref ) : m_ref( ref ) {}
+
+        auto setFlag( bool flag ) -> ParserResult override {
+            m_ref = flag;
+            return ParserResult::ok( ParseResultType::Matched );
+        }
+        auto captureDefault() const -> std::shared_ptr<BoundDefault> override {
+            return std::make_shared<BoundDefaultValue<bool>>( m_ref );
+        }
+    };
+
+    // As BoundFlagRef, but ends the parse once set - for help. Unlike a lambda, the flag can be
+    // restored between the parses of a ParseSession
+    struct BoundHelpFlagRef : BoundFlagRef {
+        using BoundFlagRef::BoundFlagRef;
+
+        auto setFlag( bool flag ) -> ParserResult override {
+            m_ref = flag;
+            return ParserResult::ok( ParseResultType::ShortCircuitAll );
+        }
+    };
+
+    template<typename ReturnType>
+    struct LambdaInvoker {
         static_assert( std::is_same<ReturnType, ParserResult>::value, "Lambda must return void or clara::ParserResult" );
 
         template<typename L, typename ArgType>
@@ -434,36 +1321,182 @@ namespace detail {
     }
 
 
-    template<typename L>
-    struct BoundLambda : BoundValueRefBase {
-        L m_lambda;
+    // A lambda, held without its type. Small lambdas are held in place, and larger ones copied to the heap
+    class ErasedLambda {
+        static const size_t InlineSize = 6 * sizeof( void * );
 
-        static_assert( UnaryLambdaTraits<L>::isValid, "Supplied lambda must take exactly one argument" );
-        explicit BoundLambda( L const &lambda ) : m_lambda( lambda ) {}
+        // Lambdas that capture a few references, or a std::string or std::function by value, fit here.
+        // Others (including any that need stricter alignment than a pointer) go on the heap
+        alignas( void * ) unsigned char m_inline[InlineSize];
+        void *m_lambda;
+        void ( *m_destroy )( void *lambda ) = nullptr;
 
-        auto setValue( std::string const &arg ) -> ParserResult override {
-            return invokeLambda<typename UnaryLambdaTraits<L>::ArgType>( m_lambda, arg );
+        template<typename L>
+        void hold( L const &lambda, std::true_type ) {
+            m_lambda = new( m_inline ) L( lambda );
+            m_destroy = []( void *lambda ) { static_cast<L *>( lambda )->~L(); };
+        }
+        template<typename L>
+        void hold( L const &lambda, std::false_type ) {
+            m_lambda = new L( lambda );
+            m_destroy = []( void *lambda ) { delete static_cast<L *>( lambda ); };
+        }
+
+    public:
+        template<typename L>
+        explicit ErasedLambda( L const &lambda ) {
+            hold( lambda, std::integral_constant<bool,
+                sizeof( L ) <= InlineSize &&
+                alignof( L ) <= alignof( void * )>() );
+        }
+        ~ErasedLambda() {
+            if( m_destroy )
+                m_destroy( m_lambda );
         }
+        ErasedLambda( ErasedLambda const & ) = delete;
+        auto operator=( ErasedLambda const & ) -> ErasedLambda & = delete;
+
+        auto get() const -> void const * { return m_lambda; }
     };
 
     template<typename L>
-    struct BoundFlagLambda : BoundFlagRefBase {
-        L m_lambda;
+    auto invokeErasedLambda( void const *lambda, std::string const &arg ) -> ParserResult {
+        return invokeLambda<typename UnaryLambdaTraits<L>::ArgType>( *static_cast<L const *>( lambda ), arg );
+    }
+    template<typename L>
+    auto invokeErasedFlagLambda( void const *lambda, bool flag ) -> ParserResult {
+        return LambdaInvoker<typename UnaryLambdaTraits<L>::ReturnType>::invoke( *static_cast<L const *>( lambda ), flag );
+    }
+
+    // Lambdas are bound through a function pointer that converts the arg and invokes them,
+    // so each lambda only adds that function, rather than a class with its own vtable
+    class BoundLambda : public BoundValueRefBase {
+        ErasedLambda m_lambda;
+        auto ( *m_invoke )( void const *lambda, std::string const &arg ) -> ParserResult;
+
+    public:
+        template<typename L>
+        explicit BoundLambda( L const &lambda ) : m_lambda( lambda ), m_invoke( &invokeErasedLambda<L> ) {
+            static_assert( UnaryLambdaTraits<L>::isValid, "Supplied lambda must take exactly one argument" );
+        }
+
+        auto setValue( std::string const &arg ) -> ParserResult override {
+            return m_invoke( m_lambda.get(), arg );
+        }
+        auto conversionKind() const -> ConversionKind override { return ConversionKind::Lambda; }
+    };
 
-        static_assert( UnaryLambdaTraits<L>::isValid, "Supplied lambda must take exactly one argument" );
-        static_assert( std::is_same<typename UnaryLambdaTraits<L>::ArgType, bool>::value, "flags must be boolean" );
+    class BoundFlagLambda : public BoundFlagRefBase {
+        ErasedLambda m_lambda;
+        auto ( *m_invoke )( void const *lambda, bool flag ) -> ParserResult;
 
-        explicit BoundFlagLambda( L const &lambda ) : m_lambda( lambda ) {}
+    public:
+        template<typename L>
+        explicit BoundFlagLambda( L const &lambda ) : m_lambda( lambda ), m_invoke( &invokeErasedFlagLambda<L> ) {
+            static_assert( UnaryLambdaTraits<L>::isValid, "Supplied lambda must take exactly one argument" );
+            static_assert( std::is_same<typename UnaryLambdaTraits<L>::ArgType, bool>::value, "flags must be boolean" );
+        }
 
         auto setFlag( bool flag ) -> ParserResult override {
-            return LambdaInvoker<typename UnaryLambdaTraits<L>::ReturnType>::invoke( m_lambda, flag );
+            return m_invoke( m_lambda.get(), flag );
         }
+        auto conversionKind() const -> ConversionKind override { return ConversionKind::Lambda; }
     };
 
+    // Counts and times a conversion (or lambda callback), if a ParseObserver is attached
+    template<typename F>
+    inline auto observeConversion( ParseObserver *observer, BoundRef const &ref, F const &convert ) -> ParserResult {
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+        if( observer ) {
+            auto kind = ref.conversionKind();
+            PhaseTimer timer( observer, kind == ConversionKind::Lambda ? ParsePhase::Callback : ParsePhase::Convert );
+            observer->converted( kind );
+            return convert();
+        }
+#else
+        (void)observer;
+        (void)ref;
+#endif
+        return convert();
+    }
+
     enum class Optionality { Optional, Required };
 
+    // The text of an option name, hint or description. Copied in by default, but text that is known
+    // to outlive the parser (a string literal, say) can be referred to instead - see literal(). From C++17,
+    // a std::string_view is referred to as well, as it does not own its text either
+    class TextRef {
+        std::string m_owned;
+        char const *m_referred = nullptr;
+        size_t m_size = 0;
+
+        TextRef( char const *text, size_t size ) : m_referred( text ), m_size( size ) {}
+
+    public:
+        TextRef() = default;
+
+        template<typename T, typename = typename std::enable_if<std::is_convertible<T, std::string>::value>::type>
+        TextRef( T &&text ) : m_owned( std::forward<T>( text ) ) {}
+
+#ifdef CLARA_CONFIG_STRING_VIEW
+        TextRef( std::string_view text ) : TextRef( text.data(), text.size() ) {}
+#endif
+
+        // For null terminated text that is known to outlive the parser, such as the strings of an OptSpec
+        static auto literal( char const *text ) -> TextRef {
+            return TextRef( text, std::strlen( text ) );
+        }
+
+        auto data() const -> char const * { return m_referred ? m_referred : m_owned.data(); }
+        auto size() const -> size_t { return m_referred ? m_size : m_owned.size(); }
+        auto empty() const -> bool { return size() == 0; }
+        auto operator[]( size_t index ) const -> char { return data()[index]; }
+        auto str() const -> std::string { return m_referred ? std::string( m_referred, m_size ) : m_owned; }
+
+        friend auto operator==( TextRef const &text, std::string const &other ) -> bool {
+            return text.size() == other.size() && std::memcmp( text.data(), other.data(), other.size() ) == 0;
+        }
+        friend auto operator<<( std::ostream &os, TextRef const &text ) -> std::ostream & {
+            return os.write( text.data(), static_cast<std::streamsize>( text.size() ) );
+        }
+    };
+
+    // Refers to the text, rather than copying it, for the names, hints and descriptions of large
+    // parsers built from string literals: Opt( count, literal( "count" ) )[literal( "--count" )].
+    // The text must outlive the parser, and every copy of it
+    template<size_t N>
+    auto literal( char const ( &text )[N] ) -> TextRef {
+        return TextRef::literal( text );
+    }
+
+    // The description of an option or argument, for help. Held as text (see TextRef) or as a
+    // callback that builds it only when help is rendered
+    class Description {
+        TextRef m_text;
+        std::function<std::string()> m_build;
+
+    public:
+        Description() = default;
+        explicit Description( TextRef text ) : m_text( std::move( text ) ) {}
+
+        static auto builtBy( std::function<std::string()> build ) -> Description {
+            Description description;
+            description.m_build = std::move( build );
+            return description;
+        }
+
+        auto str() const -> std::string {
+            if( m_build )
+                return m_build();
+            return m_text.str();
+        }
+    };
+
     struct Parser;
 
+    // Checks a value once the whole command line has been parsed - see ParserRefImpl::validatedBy
+    using ValueValidator = std::function<ParserResult( std::string const &value )>;
+
     class ParserBase {
     public:
         virtual ~ParserBase() = default;
@@ -471,8 +1504,12 @@ namespace detail {
         virtual auto parse( std::string const& exeName, TokenStream const &tokens) const -> InternalParseResult  = 0;
         virtual auto cardinality() const -> size_t { return 1; }
 
+        // The short options that take values, for splitting clusters such as -ofile
+        virtual auto shortValueOpts() const -> ShortValueOpts { return {}; }
+
         auto parse( Args const &args ) const -> InternalParseResult {
-            return parse( args.exeName(), TokenStream( args ) );
+            TokenTable table( args, shortValueOpts() );
+            return detachTokens( parse( args.exeName(), TokenStream( table ) ) );
         }
     };
 
@@ -492,29 +1529,61 @@ namespace detail {
     protected:
         Optionality m_optionality = Optionality::Optional;
         std::shared_ptr<BoundRef> m_ref;
-        std::string m_hint;
-        std::string m_description;
+        TextRef m_hint;
+        Description m_description;
+        bool m_hidden = false;
+        ValueValidator m_validator;
 
         explicit ParserRefImpl( std::shared_ptr<BoundRef> const &ref ) : m_ref( ref ) {}
 
     public:
         template<typename T>
-        ParserRefImpl( T &ref, std::string const &hint )
-        :   m_ref( std::make_shared<BoundValueRef<T>>( ref ) ),
-            m_hint( hint )
+        ParserRefImpl( T &ref, TextRef hint )
+        :   m_ref( makeBoundValue( ref ) ),
+            m_hint( std::move( hint ) )
         {}
 
         template<typename LambdaT>
-        ParserRefImpl( LambdaT const &ref, std::string const &hint )
-        :   m_ref( std::make_shared<BoundLambda<LambdaT>>( ref ) ),
-            m_hint(hint)
+        ParserRefImpl( LambdaT const &ref, TextRef hint )
+        :   m_ref( std::make_shared<BoundLambda>( ref ) ),
+            m_hint( std::move( hint ) )
+        {}
+
+        template<typename T, typename ValueT>
+        ParserRefImpl( T &ref, Choices<ValueT> const &choices, TextRef hint )
+        :   m_ref( std::make_shared<BoundChoiceRef<T, ValueT>>( ref, choices ) ),
+            m_hint( std::move( hint ) )
         {}
 
-        auto operator()( std::string const &description ) -> DerivedT & {
-            m_description = description;
+        auto operator()( TextRef description ) -> DerivedT & {
+            m_description = Description( std::move( description ) );
+            return static_cast<DerivedT &>( *this );
+        }
+
+        // The description is only built, by calling this, when help is rendered
+        auto describedBy( std::function<std::string()> describe ) -> DerivedT & {
+            m_description = Description::builtBy( std::move( describe ) );
             return static_cast<DerivedT &>( *this );
         }
 
+        // Still parsed, but left out of help (and completion)
+        auto hidden() -> DerivedT & {
+            m_hidden = true;
+            return static_cast<DerivedT &>( *this );
+        }
+        auto isHidden() const -> bool { return m_hidden; }
+
+        // Checks each argument this parses, as given on the command line, once the whole command line
+        // has parsed and met its constraints - so that costly checks (that a file exists, say) don't hold
+        // up parsing, and can run in parallel (see Parser::validationThreads). A validator returns an ok
+        // ParserResult, or a runtimeError describing what is wrong with the value. Validators of a Parser
+        // may be called concurrently with each other, and with themselves, so must be thread safe
+        auto validatedBy( ValueValidator validator ) -> DerivedT & {
+            m_validator = std::move( validator );
+            return static_cast<DerivedT &>( *this );
+        }
+        auto validator() const -> ValueValidator const & { return m_validator; }
+
         auto optional() -> DerivedT & {
             m_optionality = Optionality::Optional;
             return static_cast<DerivedT &>( *this );
@@ -536,7 +1605,19 @@ namespace detail {
                 return 1;
         }
 
-        auto hint() const -> std::string { return m_hint; }
+        auto validate() const -> Result override {
+            return m_ref->validate();
+        }
+
+        auto hint() const -> std::string { return m_hint.str(); }
+        auto description() const -> std::string { return m_description.str(); }
+        auto valueNames() const -> std::vector<std::string> { return m_ref->valueNames(); }
+
+        // Adds the current value of the bound variable, to be restored before each parse of a ParseSession
+        void captureDefaults( std::vector<std::shared_ptr<BoundDefault>> &defaults ) const {
+            if( auto captured = m_ref->captureDefault() )
+                defaults.push_back( captured );
+        }
     };
 
     class ExeName : public ComposableParserImpl<ExeName> {
@@ -545,19 +1626,19 @@ namespace detail {
 
         template<typename LambdaT>
         static auto makeRef(LambdaT const &lambda) -> std::shared_ptr<BoundValueRefBase> {
-            return std::make_shared<BoundLambda<LambdaT>>( lambda) ;
+            return std::make_shared<BoundLambda>( lambda );
         }
 
     public:
         ExeName() : m_name( std::make_shared<std::string>( "<executable>" ) ) {}
 
         explicit ExeName( std::string &ref ) : ExeName() {
-            m_ref = std::make_shared<BoundValueRef<std::string>>( ref );
+            m_ref = makeBoundValue( ref );
         }
 
         template<typename LambdaT>
         explicit ExeName( LambdaT const& lambda ) : ExeName() {
-            m_ref = std::make_shared<BoundLambda<LambdaT>>( lambda );
+            m_ref = std::make_shared<BoundLambda>( lambda );
         }
 
         // The exe name is not parsed out of the normal tokens, but is handled specially
@@ -566,44 +1647,39 @@ namespace detail {
         }
 
         auto name() const -> std::string { return *m_name; }
-        auto set( std::string const& newName ) -> ParserResult {
+        auto set( std::string const& newName ) -> ParserResult;
+    };
 
-            auto lastSlash = newName.find_last_of( "\\/" );
-            auto filename = ( lastSlash == std::string::npos )
-                    ? newName
-                    : newName.substr( lastSlash+1 );
+    class Arg : public ParserRefImpl<Arg> {
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+        size_t m_conversionThreads = 1;
+#endif
 
-            *m_name = filename;
-            if( m_ref )
-                return m_ref->setValue( filename );
-            else
-                return ParserResult::ok( ParseResultType::Matched );
+        auto setValues( BoundValueRefBase &valueRef, BoundValueRefBase::ArgIterator first, BoundValueRefBase::ArgIterator last ) const -> ParserResult {
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+            if( m_conversionThreads != 1 )
+                return valueRef.setValuesInParallel( first, last, m_conversionThreads );
+#endif
+            return valueRef.setValues( first, last );
         }
-    };
 
-    class Arg : public ParserRefImpl<Arg> {
     public:
         using ParserRefImpl::ParserRefImpl;
 
-        auto parse( std::string const &, TokenStream const &tokens ) const -> InternalParseResult override {
-            auto validationResult = validate();
-            if( !validationResult )
-                return InternalParseResult( validationResult );
-
-            auto remainingTokens = tokens;
-            auto const &token = *remainingTokens;
-            if( token.type != TokenType::Argument )
-                return InternalParseResult::ok( ParseState( ParseResultType::NoMatch, remainingTokens ) );
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+        // For containers: converts each run of consecutive arguments in one go, split across this many
+        // threads (0 for one per core, and never more). Only worthwhile for many thousands of arguments, or costly conversions
+        auto parallel( size_t threads = 0 ) -> Arg & {
+            m_conversionThreads = threads;
+            return *this;
+        }
+#endif
 
-            assert( !m_ref->isFlag() );
-            auto valueRef = static_cast<detail::BoundValueRefBase*>( m_ref.get() );
+        auto parse( std::string const &, TokenStream const &tokens ) const -> InternalParseResult override;
 
-            auto result = valueRef->setValue( remainingTokens->token );
-            if( !result )
-                return InternalParseResult( result );
-            else
-                return InternalParseResult::ok( ParseState( ParseResultType::Matched, ++remainingTokens ) );
-        }
+        // Hands all the remaining tokens to this (variadic) Arg in one go.
+        // Only valid once the tokens are past the "--" marker
+        auto parseRemaining( TokenStream const &tokens ) const -> InternalParseResult;
     };
 
     inline auto normaliseOpt( std::string const &optName ) -> std::string {
@@ -615,46 +1691,80 @@ namespace detail {
             return optName;
     }
 
+    // Compares an option name with a normalised token, without copying the name
+    inline auto matchesOptName( TextRef const &name, std::string const &normalisedToken ) -> bool {
+#ifdef CLARA_PLATFORM_WINDOWS
+        if( !name.empty() && name[0] == '/' )
+            return normaliseOpt( name.str() ) == normalisedToken;
+#endif
+        return name == normalisedToken;
+    }
+
     class Opt : public ParserRefImpl<Opt> {
     protected:
-        std::vector<std::string> m_optNames;
+        std::vector<TextRef> m_optNames;
+        char m_delimiter = '\0';
+        std::shared_ptr<BoundValueRefBase> m_optionalArg; // Only for flags - e.g. --help <term>
 
     public:
         template<typename LambdaT>
-        explicit Opt( LambdaT const &ref ) : ParserRefImpl( std::make_shared<BoundFlagLambda<LambdaT>>( ref ) ) {}
+        explicit Opt( LambdaT const &ref ) : ParserRefImpl( std::make_shared<BoundFlagLambda>( ref ) ) {}
 
         explicit Opt( bool &ref ) : ParserRefImpl( std::make_shared<BoundFlagRef>( ref ) ) {}
 
+        explicit Opt( std::shared_ptr<BoundRef> const &ref ) : ParserRefImpl( ref ) {}
+
         template<typename LambdaT>
-        Opt( LambdaT const &ref, std::string const &hint ) : ParserRefImpl( ref, hint ) {}
+        Opt( LambdaT const &ref, TextRef hint ) : ParserRefImpl( ref, std::move( hint ) ) {}
 
         template<typename T>
-        Opt( T &ref, std::string const &hint ) : ParserRefImpl( ref, hint ) {}
+        Opt( T &ref, TextRef hint ) : ParserRefImpl( ref, std::move( hint ) ) {}
 
-        auto operator[]( std::string const &optName ) -> Opt & {
-            m_optNames.push_back( optName );
+        template<typename T, typename ValueT>
+        Opt( T &ref, Choices<ValueT> const &choices, TextRef hint ) : ParserRefImpl( ref, choices, std::move( hint ) ) {}
+
+        auto operator[]( TextRef optName ) -> Opt & {
+            m_optNames.push_back( std::move( optName ) );
             return *this;
         }
 
-        auto getHelpColumns() const -> std::vector<HelpColumns> {
-            std::ostringstream oss;
-            bool first = true;
-            for( auto const &opt : m_optNames ) {
-                if (first)
-                    first = false;
-                else
-                    oss << ", ";
-                oss << opt;
+        // Splits the option's argument on the delimiter and sets each element in turn
+        // (e.g. --ids=1,2,3). Bound containers are reserved up front, and integers are
+        // converted directly from the argument string
+        auto delimiter( char delimiter ) -> Opt & {
+            m_delimiter = delimiter;
+            return *this;
+        }
+
+        auto getHelpColumns() const -> std::vector<HelpColumns>;
+
+        auto optNames() const -> std::vector<TextRef> const & { return m_optNames; }
+        auto isFlag() const -> bool { return m_ref->isFlag(); }
+
+        // Adds the short names of this option, if it takes a value
+        void addShortValueOpts( ShortValueOpts &shortValueOpts ) const;
+
+        auto shortValueOpts() const -> ShortValueOpts override {
+            ShortValueOpts shortValueOpts;
+            addShortValueOpts( shortValueOpts );
+            return shortValueOpts;
+        }
+
+        void captureDefaults( std::vector<std::shared_ptr<BoundDefault>> &defaults ) const {
+            ParserRefImpl::captureDefaults( defaults );
+            if( m_optionalArg ) {
+                if( auto captured = m_optionalArg->captureDefault() )
+                    defaults.push_back( captured );
             }
-            if( !m_hint.empty() )
-                oss << " <" << m_hint << ">";
-            return { { oss.str(), m_description } };
         }
 
         auto isMatch( std::string const &optToken ) const -> bool {
-            auto normalisedToken = normaliseOpt( optToken );
+#ifdef CLARA_PLATFORM_WINDOWS
+            if( !optToken.empty() && optToken[0] == '/' )
+                return isMatch( normaliseOpt( optToken ) );
+#endif
             for( auto const &name : m_optNames ) {
-                if( normaliseOpt( name ) == normalisedToken )
+                if( matchesOptName( name, optToken ) )
                     return true;
             }
             return false;
@@ -662,250 +1772,2525 @@ namespace detail {
 
         using ParserBase::parse;
 
-        auto parse( std::string const&, TokenStream const &tokens ) const -> InternalParseResult override {
-            auto validationResult = validate();
-            if( !validationResult )
-                return InternalParseResult( validationResult );
-
-            auto remainingTokens = tokens;
-            if( remainingTokens && remainingTokens->type == TokenType::Option ) {
-                auto const &token = *remainingTokens;
-                if( isMatch(token.token ) ) {
-                    if( m_ref->isFlag() ) {
-                        auto flagRef = static_cast<detail::BoundFlagRefBase*>( m_ref.get() );
-                        auto result = flagRef->setFlag( true );
-                        if( !result )
-                            return InternalParseResult( result );
-                        if( result.value() == ParseResultType::ShortCircuitAll )
-                            return InternalParseResult::ok( ParseState( result.value(), remainingTokens ) );
-                    } else {
-                        auto valueRef = static_cast<detail::BoundValueRefBase*>( m_ref.get() );
-                        ++remainingTokens;
-                        if( !remainingTokens )
-                            return InternalParseResult::runtimeError( "Expected argument following " + token.token );
-                        auto const &argToken = *remainingTokens;
-                        if( argToken.type != TokenType::Argument )
-                            return InternalParseResult::runtimeError( "Expected argument following " + token.token );
-                        auto result = valueRef->setValue( argToken.token );
-                        if( !result )
-                            return InternalParseResult( result );
-                        if( result.value() == ParseResultType::ShortCircuitAll )
-                            return InternalParseResult::ok( ParseState( result.value(), remainingTokens ) );
-                    }
-                    return InternalParseResult::ok( ParseState( ParseResultType::Matched, ++remainingTokens ) );
-                }
-            }
-            return InternalParseResult::ok( ParseState( ParseResultType::NoMatch, remainingTokens ) );
-        }
+        auto parse( std::string const&, TokenStream const &tokens ) const -> InternalParseResult override;
 
-        auto validate() const -> Result override {
-            if( m_optNames.empty() )
-                return Result::logicError( "No options supplied to Opt" );
-            for( auto const &name : m_optNames ) {
-                if( name.empty() )
-                    return Result::logicError( "Option name cannot be empty" );
-#ifdef CLARA_PLATFORM_WINDOWS
-                if( name[0] != '-' && name[0] != '/' )
-                    return Result::logicError( "Option name must begin with '-' or '/'" );
-#else
-                if( name[0] != '-' )
-                    return Result::logicError( "Option name must begin with '-'" );
-#endif
-            }
-            return ParserRefImpl::validate();
-        }
+        auto validate() const -> Result override;
     };
 
     struct Help : Opt {
         Help( bool &showHelpFlag )
-        :   Opt([&]( bool flag ) {
-                showHelpFlag = flag;
-                return ParserResult::ok( ParseResultType::ShortCircuitAll );
-            })
+        :   Opt( std::shared_ptr<BoundRef>( std::make_shared<BoundHelpFlagRef>( showHelpFlag ) ) )
         {
             static_cast<Opt &>( *this )
-                    ("display usage information")
-                    ["-?"]["-h"]["--help"]
+                    ( literal( "display usage information" ) )
+                    [literal( "-?" )][literal( "-h" )][literal( "--help" )]
                     .optional();
         }
+
+        // Also takes an optional search term, for showing only the matching options (see Parser::search)
+        Help( bool &showHelpFlag, std::string &searchTerm ) : Help( showHelpFlag ) {
+            m_optionalArg = makeBoundValue( searchTerm );
+            m_description = Description( literal( "display usage information, or just the options matching a search term" ) );
+        }
     };
 
+    // An inverted index over the rows of help, for searching the options of large parsers.
+    // The option names and hints (the left column) and descriptions (the right) are split into
+    // lower case words, each mapping to the rows it appears in - weighted so that matches in the
+    // names rank above matches in descriptions. The words are kept sorted, so each word of a search
+    // can match as a prefix with a binary search. Rows must match every word of the search
+    class HelpIndex {
+        struct Posting {
+            std::uint32_t row;
+            std::uint32_t score;
+        };
+        struct Term {
+            std::string word;
+            std::vector<Posting> postings; // In row order
+        };
+        std::vector<HelpColumns> m_rows;
+        std::vector<Term> m_terms; // Sorted by word
 
-    struct Parser : ParserBase {
+        template<typename F>
+        static void forEachWord( std::string const &text, F const &f );
 
-        mutable ExeName m_exeName;
-        std::vector<Opt> m_options;
-        std::vector<Arg> m_args;
+        // Sorts by row, keeping the best score for each
+        static void mergePostings( std::vector<Posting> &postings );
 
-        auto operator|=( ExeName const &exeName ) -> Parser & {
-            m_exeName = exeName;
-            return *this;
-        }
+        using TermRange = std::pair<std::vector<Term>::const_iterator, std::vector<Term>::const_iterator>;
 
-        auto operator|=( Arg const &arg ) -> Parser & {
-            m_args.push_back(arg);
-            return *this;
-        }
+        // The terms that start with the word
+        auto termsMatching( std::string const &word ) const -> TermRange;
 
-        auto operator|=( Opt const &opt ) -> Parser & {
-            m_options.push_back(opt);
-            return *this;
+        // Exact matches score above prefix matches
+        static auto scoreOf( std::string const &word, Term const &term, Posting const &posting ) -> std::uint32_t {
+            return term.word.size() == word.size() ? posting.score * 2 : posting.score;
         }
 
-        auto operator|=( Parser const &other ) -> Parser & {
-            m_options.insert(m_options.end(), other.m_options.begin(), other.m_options.end());
-            m_args.insert(m_args.end(), other.m_args.begin(), other.m_args.end());
-            return *this;
-        }
+    public:
+        explicit HelpIndex( std::vector<HelpColumns> rows );
 
-        template<typename T>
-        auto operator|( T const &other ) const -> Parser {
-            return Parser( *this ) |= other;
-        }
+        // Returns the rows matching every word in the query, best matches first.
+        // The word with the fewest matches is looked up first, so the rest only need
+        // checking (by binary search) against the rows that it matched
+        auto search( std::string const &query ) const -> std::vector<HelpColumns>;
+    };
 
-        // Forward deprecated interface with '+' instead of '|'
-        template<typename T>
+    // A Parser's HelpIndex, built by the first search. Searching is const, so may happen on several
+    // threads at once: the first builds the index, under the lock, and any others wait for it.
+    // The lock and the index live in a State, defined with the other definitions (so that <mutex> is
+    // only included there) and created when first needed - so a Parser that is never searched has none
+    class LazyHelpIndex {
+        struct State;
+        std::unique_ptr<State> m_state;
+
+        auto existingState() const -> State *;
+        auto createdState() -> State &;
+        auto load() const -> std::shared_ptr<HelpIndex const>;
+
+    public:
+        LazyHelpIndex();
+        LazyHelpIndex( LazyHelpIndex const &other );
+        auto operator=( LazyHelpIndex const &other ) -> LazyHelpIndex &;
+        ~LazyHelpIndex();
+
+        auto get( std::function<std::vector<HelpColumns>()> const &buildRows ) -> std::shared_ptr<HelpIndex const>;
+        void reset();
+    };
+
+
+    // A set of options, by their index in a Parser. The first 512 are held in place, and any more
+    // (in the largest parsers) on the heap
+    class OptionSet {
+        static const size_t InlineWords = 8;
+        std::uint64_t m_inline[InlineWords] = {};
+        std::vector<std::uint64_t> m_more;
+
+        auto words() const -> size_t { return InlineWords + m_more.size(); }
+        auto bits( size_t word ) const -> std::uint64_t {
+            if( word < InlineWords )
+                return m_inline[word];
+            return word - InlineWords < m_more.size() ? m_more[word - InlineWords] : 0;
+        }
+        static auto popCount( std::uint64_t bits ) -> size_t {
+            size_t count = 0;
+            for( ; bits; bits &= bits - 1 )
+                ++count;
+            return count;
+        }
+
+    public:
+        OptionSet() = default;
+
+        // With room for this many options, so adding any of them doesn't allocate
+        explicit OptionSet( size_t options )
+        :   m_more( options > InlineWords * 64 ? ( options + 63 ) / 64 - InlineWords : 0 )
+        {}
+
+        void add( size_t index ) {
+            auto word = index / 64;
+            auto bit = std::uint64_t( 1 ) << ( index % 64 );
+            if( word < InlineWords ) {
+                m_inline[word] |= bit;
+                return;
+            }
+            if( word - InlineWords >= m_more.size() )
+                m_more.resize( word - InlineWords + 1 );
+            m_more[word - InlineWords] |= bit;
+        }
+        // How many of the options in this set are also in the other
+        auto countIn( OptionSet const &other ) const -> size_t {
+            size_t count = 0;
+            for( size_t word = 0; word < words(); ++word )
+                count += popCount( bits( word ) & other.bits( word ) );
+            return count;
+        }
+        auto count() const -> size_t { return countIn( *this ); }
+
+        // The same options, once this many more have been added before them (by merging parsers)
+        auto shiftedBy( size_t offset ) const -> OptionSet {
+            OptionSet shifted;
+            for( size_t word = 0; word < words(); ++word ) {
+                for( auto wordBits = bits( word ); wordBits; wordBits &= wordBits - 1 ) {
+                    size_t bit = 0;
+                    while( !( ( wordBits >> bit ) & 1 ) )
+                        ++bit;
+                    shifted.add( word * 64 + bit + offset );
+                }
+            }
+            return shifted;
+        }
+    };
+
+    enum class ConstraintKind {
+        Exclusive,  // At most one of the options may be given
+        AtLeastOne, // At least one must be
+        AllOrNone,  // All of them or none of them
+        DependsOn   // If the first is given, all of the others must be too
+    };
+
+    // A constraint between options, as sets of their indices, so it is checked against
+    // the options seen by a parse with a few word operations
+    struct OptConstraint {
+        ConstraintKind kind;
+        std::vector<std::string> names;
+        OptionSet options;    // For DependsOn, the options depended on
+        OptionSet dependents; // Only for DependsOn
+        std::string error; // Set if the constraint cannot be checked - if a name did not match any option, say
+
+        auto isViolatedBy( OptionSet const &seen ) const -> bool;
+
+        auto describeViolation() const -> std::string;
+    };
+
+    // A parsed argument, waiting for the validator of the Opt or Arg that parsed it
+    struct PendingValidation {
+        ValueValidator const *validator;
+        std::string const *value; // Owned by the TokenTable being parsed
+        size_t token;
+        size_t arg;
+    };
+
+    // Calls each validator with its value and returns the results, in the same order. With
+    // CLARA_CONFIG_PARALLEL_VALIDATION the calls are shared between up to this many threads (0 for one
+    // per core) of the WorkerPool - otherwise they are made in turn, on this thread
+    auto runValidations( std::vector<PendingValidation> const &pending, size_t threads ) -> std::vector<ParserResult>;
+
+    struct Parser : ParserBase {
+
+        mutable ExeName m_exeName;
+        std::vector<Opt> m_options;
+        std::vector<Arg> m_args;
+        std::vector<OptConstraint> m_constraints;
+        mutable LazyHelpIndex m_helpIndex;
+#ifdef CLARA_CONFIG_PARALLEL_VALIDATION
+        size_t m_validationThreads = 0;
+
+        // Runs the validators of the options and args (see validatedBy) on up to this many threads -
+        // 0, the default, for one per core, which is also the most used. The results are reported in the order
+        // of the tokens validated
+        auto validationThreads( size_t threads ) -> Parser & {
+            m_validationThreads = threads;
+            return *this;
+        }
+#endif
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+        ParseObserver *m_observer = nullptr;
+
+        // Reports tokenisation, dispatch and conversion events from each parse to the observer,
+        // which must outlive any parses
+        auto observer( ParseObserver *observer ) -> Parser & {
+            m_observer = observer;
+            return *this;
+        }
+#endif
+
+        auto operator|=( ExeName const &exeName ) -> Parser & {
+            m_exeName = exeName;
+            return *this;
+        }
+
+        auto operator|=( Arg const &arg ) -> Parser & {
+            m_helpIndex.reset();
+            m_args.push_back(arg);
+            return *this;
+        }
+
+        auto operator|=( Opt const &opt ) -> Parser & {
+            m_helpIndex.reset();
+            m_options.push_back(opt);
+            return *this;
+        }
+
+        auto operator|=( Parser const &other ) -> Parser & {
+            m_helpIndex.reset();
+            // The other's constraints keep to its own options, even if they share names with these
+            auto offset = m_options.size();
+            m_options.insert(m_options.end(), other.m_options.begin(), other.m_options.end());
+            m_args.insert(m_args.end(), other.m_args.begin(), other.m_args.end());
+            for( auto const &constraint : other.m_constraints ) {
+                m_constraints.push_back( constraint );
+                m_constraints.back().options = constraint.options.shiftedBy( offset );
+                m_constraints.back().dependents = constraint.dependents.shiftedBy( offset );
+            }
+            return *this;
+        }
+
+        // Constraints between options, checked at the end of each parse. The options must already
+        // have been added, and are named by any of their names
+        auto exclusive( std::vector<std::string> const &names ) -> Parser & {
+            return constrain( ConstraintKind::Exclusive, names );
+        }
+        auto atLeastOne( std::vector<std::string> const &names ) -> Parser & {
+            return constrain( ConstraintKind::AtLeastOne, names );
+        }
+        auto allOrNone( std::vector<std::string> const &names ) -> Parser & {
+            return constrain( ConstraintKind::AllOrNone, names );
+        }
+        // If the option is given, all of the required ones must be too
+        auto dependsOn( std::string const &name, std::vector<std::string> const &required ) -> Parser & {
+            std::vector<std::string> names{ name };
+            names.insert( names.end(), required.begin(), required.end() );
+            return constrain( ConstraintKind::DependsOn, names );
+        }
+
+        auto constrain( ConstraintKind kind, std::vector<std::string> const &names ) -> Parser &;
+
+        // The index of the option with this name, or the number of options if there isn't one
+        auto findOption( std::string const &name ) const -> size_t;
+
+        template<typename T>
+        auto operator|( T const &other ) const -> Parser {
+            return Parser( *this ) |= other;
+        }
+
+        // Forward deprecated interface with '+' instead of '|'
+        template<typename T>
         auto operator+=( T const &other ) -> Parser & { return operator|=( other ); }
         template<typename T>
         auto operator+( T const &other ) const -> Parser { return operator|( other ); }
 
-        auto getHelpColumns() const -> std::vector<HelpColumns> {
-            std::vector<HelpColumns> cols;
-            for (auto const &o : m_options) {
-                auto childCols = o.getHelpColumns();
-                cols.insert( cols.end(), childCols.begin(), childCols.end() );
-            }
-            return cols;
+        auto getHelpColumns() const -> std::vector<HelpColumns>;
+
+        void writeToStream( std::ostream &os ) const;
+
+        // The help rows of the options matching every word of the query (as prefixes), best first
+        auto search( std::string const &query ) const -> std::vector<HelpColumns>;
+
+        void writeSearchToStream( std::ostream &os, std::string const &query ) const {
+            writeHelpRows( os, search( query ) );
+        }
+
+        friend auto operator<<( std::ostream &os, Parser const &parser ) -> std::ostream& {
+            parser.writeToStream( os );
+            return os;
+        }
+
+        auto validate() const -> Result override;
+
+        using ParserBase::parse;
+
+        auto shortValueOpts() const -> ShortValueOpts override;
+
+        auto parse( Args const &args ) const -> InternalParseResult;
+
+        // Parses as much as possible, carrying on from the next token after each error, and
+        // returns every error found (none if the parse succeeded). Only an invalid parser is an error itself
+        auto parseCollectingErrors( Args const &args ) const -> DiagnosticsResult;
+
+        auto parse( std::string const& exeName, TokenStream const &tokens ) const -> InternalParseResult override {
+            return parseTokens( exeName, tokens, nullptr );
+        }
+
+    private:
+        // Records the error from parsers[i] at the current token and returns the tokens to carry on from -
+        // after the option's argument, if it was the conversion of that which failed
+        auto recoverFrom( size_t i, TokenStream const &tokens, std::string const &message, std::vector<Diagnostic> &diagnostics ) const -> TokenStream;
+
+        // Adds the arguments from first up to last, just parsed by parsers[i], if it has a validator
+        void queueValidations( size_t i, TokenStream first, TokenStream const &last, std::vector<PendingValidation> &pending ) const;
+
+        // Runs the queued validators, and returns their errors in token order - or records them, with diagnostics
+        auto validateValues( std::vector<PendingValidation> const &pending, ParseObserver *observer, std::vector<Diagnostic> *diagnostics ) const -> InternalParseResult;
+
+        // With diagnostics, errors are recorded there and parsing carries on - otherwise it stops at the first
+        auto parseTokens( std::string const& exeName, TokenStream const &tokens, std::vector<Diagnostic> *diagnostics ) const -> InternalParseResult;
+    };
+
+    template<typename DerivedT>
+    template<typename T>
+    auto ComposableParserImpl<DerivedT>::operator|( T const &other ) const -> Parser {
+        return Parser() | static_cast<DerivedT const &>( *this ) | other;
+    }
+
+    // Parses command after command with the same parser. Each parse starts by putting every bound
+    // variable back to the value it had when the session was created, and reuses the session's token
+    // table, so that once it has grown to fit, a small command is parsed without allocating
+    class ParseSession {
+        Parser m_parser;
+        ShortValueOpts m_shortValueOpts;
+        std::vector<std::shared_ptr<BoundDefault>> m_defaults;
+        TokenTable m_tokens;
+
+    public:
+        explicit ParseSession( Parser const &parser );
+        ParseSession( ParseSession const & ) = delete;
+        auto operator=( ParseSession const & ) -> ParseSession & = delete;
+
+        // Puts every bound variable back to its default
+        void reset() {
+            for( auto const &captured : m_defaults )
+                captured->restore();
+        }
+
+        auto parse( Args const &args ) -> InternalParseResult;
+    };
+
+    // Compile-time option definitions.
+    // A table of OptSpecs can be declared constexpr, checked with static_assert (using
+    // areValidOptSpecs and areUniqueOptSpecs) and parsed by a StaticParser without building
+    // any Opt or Arg objects. Specs with no names are positional arguments; specs with no hint are flags.
+
+    struct OptSpec {
+        constexpr OptSpec( char const* shortName, char const* longName, char const* hint, char const* description )
+        :   shortName( shortName ),
+            longName( longName ),
+            hint( hint ),
+            description( description ),
+            shortHash( shortName ? hashString( shortName ) : 0 ),
+            longHash( longName ? hashString( longName ) : 0 )
+        {}
+
+        constexpr auto isPositional() const -> bool { return shortName == nullptr && longName == nullptr; }
+        constexpr auto isFlag() const -> bool { return hint == nullptr; }
+
+        char const* shortName;
+        char const* longName;
+        char const* hint;
+        char const* description;
+        std::uint32_t shortHash;
+        std::uint32_t longHash;
+    };
+
+    constexpr auto hasNoOptDelimiters( char const* name ) -> bool {
+        return *name == '\0' || ( *name != ' ' && *name != ':' && *name != '=' && hasNoOptDelimiters( name + 1 ) );
+    }
+    constexpr auto isValidOptName( char const* name ) -> bool {
+        return name == nullptr || ( isOptPrefix( name[0] ) && name[1] != '\0' && hasNoOptDelimiters( name ) );
+    }
+    constexpr auto isValidOptSpec( OptSpec const& spec ) -> bool {
+        return isValidOptName( spec.shortName ) &&
+               isValidOptName( spec.longName ) &&
+               ( !spec.isPositional() || spec.hint != nullptr );
+    }
+
+    constexpr auto optNamesEqual( char const* lhs, char const* rhs ) -> bool {
+        return *lhs == *rhs && ( *lhs == '\0' || optNamesEqual( lhs + 1, rhs + 1 ) );
+    }
+    constexpr auto optNamesClash( char const* lhs, char const* rhs ) -> bool {
+        return lhs != nullptr && rhs != nullptr && optNamesEqual( lhs, rhs );
+    }
+    constexpr auto optSpecsClash( OptSpec const& lhs, OptSpec const& rhs ) -> bool {
+        return optNamesClash( lhs.shortName, rhs.shortName ) || optNamesClash( lhs.shortName, rhs.longName ) ||
+               optNamesClash( lhs.longName, rhs.shortName ) || optNamesClash( lhs.longName, rhs.longName );
+    }
+
+    // The table checks recurse by halving the range, so the constexpr recursion depth
+    // stays logarithmic in the number of specs
+    template<std::size_t N>
+    constexpr auto areValidOptSpecs( OptSpec const (&specs)[N], std::size_t first = 0, std::size_t last = N ) -> bool {
+        return last - first == 0 ? true
+             : last - first == 1 ? isValidOptSpec( specs[first] )
+             : areValidOptSpecs( specs, first, first + ( last - first ) / 2 ) &&
+               areValidOptSpecs( specs, first + ( last - first ) / 2, last );
+    }
+
+    // Does specs[index] clash with any of the specs in [first, last)?
+    template<std::size_t N>
+    constexpr auto clashesWithAny( OptSpec const (&specs)[N], std::size_t index, std::size_t first, std::size_t last ) -> bool {
+        return last - first == 0 ? false
+             : last - first == 1 ? optSpecsClash( specs[index], specs[first] )
+             : clashesWithAny( specs, index, first, first + ( last - first ) / 2 ) ||
+               clashesWithAny( specs, index, first + ( last - first ) / 2, last );
+    }
+
+    template<std::size_t N>
+    constexpr auto areUniqueOptSpecs( OptSpec const (&specs)[N], std::size_t first = 0, std::size_t last = N ) -> bool {
+        return last - first == 0 ? true
+             : last - first == 1 ? !optNamesClash( specs[first].shortName, specs[first].longName ) &&
+                                   !clashesWithAny( specs, first, first + 1, N )
+             : areUniqueOptSpecs( specs, first, first + ( last - first ) / 2 ) &&
+               areUniqueOptSpecs( specs, first + ( last - first ) / 2, last );
+    }
+
+    template<std::size_t... Is>
+    struct IndexSequence {};
+
+    template<typename Lhs, typename Rhs>
+    struct ConcatIndexSequences;
+
+    template<std::size_t... Ls, std::size_t... Rs>
+    struct ConcatIndexSequences<IndexSequence<Ls...>, IndexSequence<Rs...>> {
+        using type = IndexSequence<Ls..., ( sizeof...( Ls ) + Rs )...>;
+    };
+
+    template<std::size_t N>
+    struct MakeIndexSequence {
+        using type = typename ConcatIndexSequences<
+                typename MakeIndexSequence<N / 2>::type,
+                typename MakeIndexSequence<N - N / 2>::type>::type;
+    };
+    template<>
+    struct MakeIndexSequence<0> { using type = IndexSequence<>; };
+    template<>
+    struct MakeIndexSequence<1> { using type = IndexSequence<0>; };
+
+    // Finds the spec an option token names by comparing its hash with each spec's in turn
+    template<std::size_t N>
+    struct HashedOptLookup {
+        static auto find( OptSpec const *specs, std::string const &optToken ) -> std::size_t {
+            auto hash = hashString( optToken.data(), optToken.data() + optToken.size() );
+            for( std::size_t i = 0; i < N; ++i ) {
+                auto const &spec = specs[i];
+                if( ( spec.shortHash == hash && spec.shortName && optToken == spec.shortName ) ||
+                    ( spec.longHash == hash && spec.longName && optToken == spec.longName ) )
+                    return i;
+            }
+            return N;
+        }
+
+        // The specs are only seen at runtime, when a flag bound to anything but a bool is a logic error
+        template<std::size_t I, typename T>
+        static constexpr auto canBind() -> bool { return true; }
+    };
+
+    // The option names of a table of specs: the short name of specs[j / 2] for even j, the long name for odd j
+    constexpr auto staticOptName( OptSpec const *specs, std::size_t j ) -> char const * {
+        return j % 2 == 0 ? specs[j / 2].shortName : specs[j / 2].longName;
+    }
+    constexpr auto staticOptHash( OptSpec const *specs, std::size_t j ) -> std::uint32_t {
+        return j % 2 == 0 ? specs[j / 2].shortHash : specs[j / 2].longHash;
+    }
+    // Orders names with their hashes - names that the specs don't have go last, and equal hashes by index
+    constexpr auto staticOptLess( OptSpec const *specs, std::uint32_t lhs, std::uint32_t rhs ) -> bool {
+        return ( staticOptName( specs, lhs ) == nullptr ) != ( staticOptName( specs, rhs ) == nullptr ) ? staticOptName( specs, lhs ) != nullptr
+             : staticOptHash( specs, lhs ) != staticOptHash( specs, rhs ) ? staticOptHash( specs, lhs ) < staticOptHash( specs, rhs )
+             : lhs < rhs;
+    }
+
+    // The first of these names (in the order of staticOptLess) with this hash, or a later one
+    inline auto findStaticOptHash( OptSpec const *specs, std::uint32_t const *first, std::uint32_t const *last, std::uint32_t hash ) -> std::uint32_t const * {
+        while( first != last ) {
+            auto mid = first + ( last - first ) / 2;
+            if( staticOptName( specs, *mid ) != nullptr && staticOptHash( specs, *mid ) < hash )
+                first = mid + 1;
+            else
+                last = mid;
+        }
+        return first;
+    }
+
+    // The names of a table of specs, in the order of staticOptLess
+    template<std::size_t Size>
+    struct StaticOptOrder {
+        std::uint32_t names[Size];
+    };
+
+    // The names are sorted at compile time by a bottom up merge sort. Each pass builds a new order,
+    // each entry of which is found by a binary search for how many of the first i entries of the merged
+    // run come from its first half [a, a + aSize), and how many from its second [b, b + bSize)
+    constexpr auto staticOptTakesFromFirst( OptSpec const *specs, std::uint32_t const *order, std::size_t a, std::size_t b, std::size_t bSize,
+                                            std::size_t i, std::size_t taken ) -> bool {
+        return taken == 0 || i - taken >= bSize || staticOptLess( specs, order[a + taken - 1], order[b + i - taken] );
+    }
+    constexpr auto staticOptTakenFromFirst( OptSpec const *specs, std::uint32_t const *order, std::size_t a, std::size_t b, std::size_t bSize,
+                                            std::size_t i, std::size_t lo, std::size_t hi ) -> std::size_t {
+        return lo == hi ? lo
+             : staticOptTakesFromFirst( specs, order, a, b, bSize, i, ( lo + hi + 1 ) / 2 )
+                ? staticOptTakenFromFirst( specs, order, a, b, bSize, i, ( lo + hi + 1 ) / 2, hi )
+                : staticOptTakenFromFirst( specs, order, a, b, bSize, i, lo, ( lo + hi + 1 ) / 2 - 1 );
+    }
+    constexpr auto staticOptMergedAfter( OptSpec const *specs, std::uint32_t const *order, std::size_t a, std::size_t aSize, std::size_t b, std::size_t bSize,
+                                         std::size_t i, std::size_t taken ) -> std::uint32_t {
+        return taken < aSize && ( i - taken >= bSize || staticOptLess( specs, order[a + taken], order[b + i - taken] ) )
+            ? order[a + taken]
+            : order[b + i - taken];
+    }
+    constexpr auto staticOptMerged( OptSpec const *specs, std::uint32_t const *order, std::size_t a, std::size_t aSize, std::size_t b, std::size_t bSize, std::size_t i ) -> std::uint32_t {
+        return staticOptMergedAfter( specs, order, a, aSize, b, bSize, i,
+            staticOptTakenFromFirst( specs, order, a, b, bSize, i, i > bSize ? i - bSize : 0, i < aSize ? i : aSize ) );
+    }
+    constexpr auto staticOptMinSize( std::size_t lhs, std::size_t rhs ) -> std::size_t { return lhs < rhs ? lhs : rhs; }
+    // Entry k of a pass merging runs of this width
+    constexpr auto staticOptMergePassAt( OptSpec const *specs, std::uint32_t const *order, std::size_t size, std::size_t width, std::size_t k ) -> std::uint32_t {
+        return staticOptMerged( specs, order,
+            k / ( 2 * width ) * ( 2 * width ),
+            staticOptMinSize( k / ( 2 * width ) * ( 2 * width ) + width, size ) - k / ( 2 * width ) * ( 2 * width ),
+            staticOptMinSize( k / ( 2 * width ) * ( 2 * width ) + width, size ),
+            staticOptMinSize( k / ( 2 * width ) * ( 2 * width ) + 2 * width, size ) - staticOptMinSize( k / ( 2 * width ) * ( 2 * width ) + width, size ),
+            k - k / ( 2 * width ) * ( 2 * width ) );
+    }
+    template<std::size_t... Ks>
+    constexpr auto staticOptMergePass( OptSpec const *specs, StaticOptOrder<sizeof...( Ks )> const &order, std::size_t width, IndexSequence<Ks...> )
+        -> StaticOptOrder<sizeof...( Ks )> {
+        return StaticOptOrder<sizeof...( Ks )>{ { staticOptMergePassAt( specs, order.names, sizeof...( Ks ), width, Ks )... } };
+    }
+    template<std::size_t Size>
+    constexpr auto sortStaticOptNames( OptSpec const *specs, StaticOptOrder<Size> const &order, std::size_t width ) -> StaticOptOrder<Size> {
+        return width >= Size ? order : sortStaticOptNames( specs, staticOptMergePass( specs, order, width, typename MakeIndexSequence<Size>::type() ), width * 2 );
+    }
+    template<std::size_t... Ks>
+    constexpr auto sortStaticOptNames( OptSpec const *specs, IndexSequence<Ks...> ) -> StaticOptOrder<sizeof...( Ks )> {
+        return sortStaticOptNames( specs, StaticOptOrder<sizeof...( Ks )>{ { static_cast<std::uint32_t>( Ks )... } }, 1 );
+    }
+
+    // Finds the spec an option token names by binary search of the option names, sorted by their
+    // hashes at compile time - so a token is only compared with the names that share its hash
+    template<std::size_t N, OptSpec const (&Specs)[N]>
+    struct CompiledOptLookup {
+        static_assert( N > 0, "Compiled static parsers need at least one spec" );
+
+        static constexpr StaticOptOrder<2 * N> order = sortStaticOptNames( Specs, typename MakeIndexSequence<2 * N>::type() );
+
+        static auto find( OptSpec const *specs, std::string const &optToken ) -> std::size_t {
+            auto hash = hashString( optToken.data(), optToken.data() + optToken.size() );
+            auto const *last = order.names + 2 * N;
+            auto name = findStaticOptHash( specs, order.names, last, hash );
+            for( ; name != last && staticOptName( specs, *name ) && staticOptHash( specs, *name ) == hash; ++name ) {
+                if( optToken == staticOptName( specs, *name ) )
+                    return *name / 2;
+            }
+            return N;
+        }
+
+        template<std::size_t I, typename T>
+        static constexpr auto canBind() -> bool {
+            return !Specs[I].isFlag() || std::is_same<T, bool>::value;
+        }
+    };
+    template<std::size_t N, OptSpec const (&Specs)[N]>
+    constexpr StaticOptOrder<2 * N> CompiledOptLookup<N, Specs>::order;
+
+    template<bool...>
+    struct BoolPack {};
+    // Whether all of them are true, without recursing over them
+    template<bool... Bs>
+    struct AllOf : std::is_same<BoolPack<true, Bs...>, BoolPack<Bs..., true>> {};
+
+    template<typename T>
+    inline auto setStaticFlag( T & ) -> ParserResult {
+        return ParserResult::logicError( "Flag options must be bound to a bool" );
+    }
+    inline auto setStaticFlag( bool &ref ) -> ParserResult {
+        ref = true;
+        return ParserResult::ok( ParseResultType::Matched );
+    }
+
+    // Parses against a (usually constexpr) table of OptSpecs, with one bound variable per spec.
+    // The specs are referenced, not copied, so must outlive the parser.
+    // Nothing is allocated on construction: the per-binding setters are generated as a
+    // static table of function pointers, and option tokens are dispatched to a spec by the
+    // Lookup - HashedOptLookup for a StaticParser, or CompiledOptLookup when the specs are
+    // known at compile time (see makeStaticParser)
+    template<std::size_t N, typename Lookup, typename... Ts>
+    class BasicStaticParser {
+        static_assert( sizeof...( Ts ) == N, "Exactly one binding must be supplied for each OptSpec" );
+
+        using Refs = std::tuple<Ts&...>;
+
+        struct Dispatch {
+            auto ( *setValue )( Refs const &, std::string const & ) -> ParserResult;
+            auto ( *setFlag )( Refs const & ) -> ParserResult;
+            bool isContainer;
+        };
+
+        OptSpec const* m_specs;
+        Refs m_refs;
+
+        template<std::size_t I>
+        static auto setValueAt( Refs const &refs, std::string const &arg ) -> ParserResult {
+            using T = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+            return ValueOpsFor<T>::ops().setValue( &std::get<I>( refs ), arg );
+        }
+        template<std::size_t I>
+        static auto setFlagAt( Refs const &refs ) -> ParserResult {
+            return setStaticFlag( std::get<I>( refs ) );
+        }
+
+        template<std::size_t... Is>
+        static auto dispatchTable( IndexSequence<Is...> ) -> Dispatch const * {
+            static Dispatch const table[] = {
+                { &setValueAt<Is>, &setFlagAt<Is>, ContainerTraits<Ts>::isContainer }...
+            };
+            return table;
+        }
+        static auto dispatchTable() -> Dispatch const * {
+            return dispatchTable( typename MakeIndexSequence<N>::type() );
+        }
+
+        template<std::size_t... Is>
+        static constexpr auto canBindAll( IndexSequence<Is...> ) -> bool {
+            return AllOf<Lookup::template canBind<Is, Ts>()...>::value;
+        }
+
+        auto findOpt( std::string const &optToken ) const -> std::size_t {
+#ifdef CLARA_PLATFORM_WINDOWS
+            if( optToken[0] == '/' )
+                return findOpt( normaliseOpt( optToken ) );
+#endif
+            return Lookup::find( m_specs, optToken );
+        }
+
+        auto parseOpt( std::size_t index, TokenStream &tokens ) const -> ParserResult {
+            if( m_specs[index].isFlag() )
+                return dispatchTable()[index].setFlag( m_refs );
+
+            auto const &optToken = tokens->token;
+            auto remainingTokens = tokens;
+            ++remainingTokens;
+            if( !remainingTokens || remainingTokens->type != TokenType::Argument )
+                return ParserResult::runtimeError( "Expected argument following " + optToken );
+            tokens = remainingTokens;
+            return dispatchTable()[index].setValue( m_refs, tokens->token );
+        }
+
+        template<std::size_t I>
+        void addToParser( Parser &parser ) const {
+            auto const &spec = m_specs[I];
+            auto &ref = std::get<I>( m_refs );
+            // The specs are constexpr, so their strings are referred to rather than copied
+            auto description = TextRef::literal( spec.description ? spec.description : "" );
+            auto hint = TextRef::literal( spec.hint ? spec.hint : "" );
+            if( spec.isPositional() ) {
+                parser |= Arg( ref, hint )( description );
+            }
+            else {
+                auto opt = Opt( ref, hint )( description );
+                if( spec.shortName )
+                    opt[TextRef::literal( spec.shortName )];
+                if( spec.longName )
+                    opt[TextRef::literal( spec.longName )];
+                parser |= opt;
+            }
+        }
+        template<std::size_t... Is>
+        void addToParser( Parser &parser, IndexSequence<Is...> ) const {
+            int expand[] = { 0, ( addToParser<Is>( parser ), 0 )... };
+            (void)expand;
+        }
+
+    public:
+        BasicStaticParser( OptSpec const (&specs)[N], Ts&... refs )
+        :   m_specs( specs ),
+            m_refs( refs... )
+        {
+            static_assert( canBindAll( typename MakeIndexSequence<N>::type() ), "Flag options must be bound to a bool" );
+        }
+
+        auto parse( Args const &args ) const -> InternalParseResult {
+            auto const *dispatch = dispatchTable();
+            auto type = ParseResultType::NoMatch;
+            std::size_t nextPositional = 0;
+
+            ShortValueOpts shortValueOpts;
+            for( std::size_t i = 0; i < N; ++i ) {
+                if( !m_specs[i].isFlag() && m_specs[i].shortName )
+                    shortValueOpts.add( m_specs[i].shortName );
+            }
+            TokenTable table( args, shortValueOpts );
+            TokenStream tokens( table );
+            while( tokens ) {
+                if( tokens->type == TokenType::Option ) {
+                    auto index = findOpt( tokens->token );
+                    if( index == N )
+                        return InternalParseResult::runtimeError( "Unrecognised token: " + tokens->token );
+                    auto result = parseOpt( index, tokens );
+                    if( !result )
+                        return InternalParseResult( result );
+                }
+                else {
+                    while( nextPositional < N && !m_specs[nextPositional].isPositional() )
+                        ++nextPositional;
+                    if( nextPositional == N )
+                        return InternalParseResult::runtimeError( "Unrecognised token: " + tokens->token );
+                    auto result = dispatch[nextPositional].setValue( m_refs, tokens->token );
+                    if( !result )
+                        return InternalParseResult( result );
+                    if( !dispatch[nextPositional].isContainer )
+                        ++nextPositional;
+                }
+                type = ParseResultType::Matched;
+                ++tokens;
+            }
+            return InternalParseResult::ok( ParseState( type, TokenStream() ) );
+        }
+
+        // Builds the equivalent dynamic parser. Only needed for help, so this is
+        // the only place that static parsers pay for constructing Opts and Args
+        auto toParser() const -> Parser {
+            Parser parser;
+            addToParser( parser, typename MakeIndexSequence<N>::type() );
+            return parser;
+        }
+
+        void writeToStream( std::ostream &os ) const {
+            toParser().writeToStream( os );
+        }
+
+        friend auto operator<<( std::ostream &os, BasicStaticParser const &parser ) -> std::ostream& {
+            parser.writeToStream( os );
+            return os;
+        }
+    };
+
+    template<std::size_t N, typename... Ts>
+    using StaticParser = BasicStaticParser<N, HashedOptLookup<N>, Ts...>;
+
+    template<std::size_t N, typename... Ts>
+    auto makeStaticParser( OptSpec const (&specs)[N], Ts&... refs ) -> StaticParser<N, Ts...> {
+        return StaticParser<N, Ts...>( specs, refs... );
+    }
+
+    // With the specs as a template argument - makeStaticParser<N, specs>( refs... ), or from C++17
+    // makeStaticParser<specs>( refs... ) - the specs are checked, flags must be bound to bools, and
+    // option tokens are dispatched through a hash table built at compile time, all by the compiler
+    template<std::size_t N, OptSpec const (&Specs)[N], typename... Ts>
+    auto makeStaticParser( Ts&... refs ) -> BasicStaticParser<N, CompiledOptLookup<N, Specs>, Ts...> {
+        static_assert( areValidOptSpecs( Specs ), "Option specs must be valid" );
+        static_assert( areUniqueOptSpecs( Specs ), "Option names must be unique" );
+        return BasicStaticParser<N, CompiledOptLookup<N, Specs>, Ts...>( Specs, refs... );
+    }
+
+#if __cplusplus >= 201703L
+    template<auto &Specs, typename... Ts>
+    auto makeStaticParser( Ts&... refs )
+        -> BasicStaticParser<std::extent<typename std::remove_reference<decltype( Specs )>::type>::value,
+                             CompiledOptLookup<std::extent<typename std::remove_reference<decltype( Specs )>::type>::value, Specs>, Ts...> {
+        return makeStaticParser<std::extent<typename std::remove_reference<decltype( Specs )>::type>::value, Specs>( refs... );
+    }
+#endif
+
+    // Shell completion.
+    // A CompletionIndex is built once from a Parser's Opt names, sorted, so each query for the
+    // word under the cursor is a binary search plus a scan of the matches. Shells call back into
+    // the program on every TAB press (see completionScript), so this avoids rendering help or
+    // running a parse just to find the candidates.
+
+    struct Completion {
+        std::string value;
+        std::string description;
+    };
+
+    struct CompletionResult {
+        std::vector<Completion> candidates; // Sorted by value
+        std::string hint;                   // Of the option whose argument is being completed, if any
+    };
+
+    class CompletionIndex {
+        struct Entry {
+            std::string name;
+            size_t opt;
+
+            friend auto operator<( Entry const &lhs, Entry const &rhs ) -> bool { return lhs.name < rhs.name; }
+        };
+        // The parser's own Opts, so that descriptions (which may be built by a callback) and
+        // value names are only looked up for the candidates a query returns
+        std::vector<Opt const *> m_opts;
+        std::vector<Entry> m_entries; // Sorted by name
+
+        auto findOpt( std::string const &name ) const -> Opt const *;
+
+        void addOptNames( std::string const &prefix, CompletionResult &result ) const;
+
+        static void addValues( Opt const &opt, std::string const &prefix, std::string const &valuePrefix, CompletionResult &result );
+
+    public:
+        // The option that shells pass (as the first argument) to request completions
+        static constexpr auto requestOption() -> char const * { return "--clara-complete"; }
+
+        static auto isRequest( Args const &args ) -> bool {
+            return !args.m_args.empty() && args.m_args[0] == requestOption();
+        }
+
+        // Refers to the parser's Opts, so the parser must outlive the index
+        explicit CompletionIndex( Parser const &parser );
+
+        // Completes words[cursor], where words is the whole command line (including the
+        // executable name). The cursor may be one past the end, for a new, empty, word
+        auto complete( std::vector<std::string> const &words, size_t cursor ) const -> CompletionResult;
+
+        // Answers a request from one of the completion scripts, if that is what the args are:
+        //   <exe> --clara-complete <cursor> <words>...
+        // Writes one candidate per line, as the value and description separated by a tab
+        auto handleRequest( Args const &args, std::ostream &os ) const -> bool;
+    };
+
+    // Builds the CompletionIndex only if the args are a completion request, so a program can call
+    // this first thing in main() and return if it answers true
+    auto handleCompletionRequest( Parser const &parser, Args const &args, std::ostream &os ) -> bool;
+
+    enum class Shell { Bash, Zsh, Fish };
+
+    // Glue for registering the executable's completions with the shell, e.g. from
+    //   source <(myapp --completion-script bash)
+    // The scripts fall back to the shell's file completion when there are no candidates
+    auto completionScript( Shell shell, std::string const &exeName ) -> std::string;
+
+    // Parser snapshots.
+    // serialiseSchema() writes the static shape of a Parser into a single blob: option names, hints,
+    // help descriptions, optionality, cardinality and a binding slot for each Opt and Arg (Opts first,
+    // then Args, in the order they were added). The blob holds only little-endian 32-bit fields and
+    // string data, addressed by offsets from its start, so it can be embedded in a binary or
+    // memory-mapped anywhere. A SchemaView checks the blob then reads it in place, so a program can
+    // parse (and show help) without constructing an Opt per option. The blob also carries a hash of its
+    // contents, which a program can compare against the hash it was generated with to reject stale
+    // snapshots.
+    //
+    // Layout:
+    //   header:     magic, version, hash, size, entry count, name count
+    //   entries:    flags, slot, first name, name count, hint offset, hint size, description offset, description size
+    //   names:      offset, size - in declaration order, each entry's names being contiguous
+    //   name index: name, entry - sorted by name, for lookups
+    //   string data
+    struct SchemaLayout {
+        enum : std::uint32_t {
+            Magic = 0x53524c43, // "CLRS"
+            Version = 1,
+            HashedFrom = 12, // The hash covers everything after itself
+            HeaderFields = 6,
+            EntryFields = 8,
+            NameFields = 2,
+            IndexFields = 2
+        };
+        enum HeaderField : std::uint32_t { MagicField, VersionField, HashField, SizeField, EntryCountField, NameCountField };
+        enum EntryField : std::uint32_t { Flags, Slot, FirstName, NameCount, HintOffset, HintSize, DescriptionOffset, DescriptionSize };
+        enum Flag : std::uint32_t { Positional = 1, IsFlag = 2, Required = 4, Unlimited = 8, Hidden = 16 };
+
+        template<typename ParserT>
+        static auto flagsOf( ParserT const &parser ) -> std::uint32_t {
+            std::uint32_t flags = 0;
+            if( !parser.isOptional() )
+                flags |= Required;
+            if( parser.cardinality() == 0 )
+                flags |= Unlimited;
+            if( parser.isHidden() )
+                flags |= Hidden;
+            return flags;
+        }
+    };
+
+    auto serialiseSchema( Parser const &parser ) -> std::string;
+
+    // Receives the values from a SchemaView parse, addressed by the slots of the original Opts and Args
+    class SchemaBindings {
+    public:
+        virtual ~SchemaBindings() = default;
+        virtual auto setValue( std::uint32_t slot, std::string const &arg ) -> ParserResult = 0;
+        virtual auto setFlag( std::uint32_t slot ) -> ParserResult = 0;
+    };
+
+    // Reads a blob from serialiseSchema() in place. The blob must outlive the view
+    class SchemaView {
+        using L = SchemaLayout;
+
+        char const *m_data;
+        std::uint32_t m_entryCount;
+        std::uint32_t m_nameCount;
+
+        SchemaView( char const *data, std::uint32_t entryCount, std::uint32_t nameCount )
+        :   m_data( data ), m_entryCount( entryCount ), m_nameCount( nameCount )
+        {}
+
+        static auto read( char const *data, size_t field ) -> std::uint32_t {
+            auto bytes = reinterpret_cast<unsigned char const *>( data ) + 4 * field;
+            return static_cast<std::uint32_t>( bytes[0] )
+                | static_cast<std::uint32_t>( bytes[1] ) << 8
+                | static_cast<std::uint32_t>( bytes[2] ) << 16
+                | static_cast<std::uint32_t>( bytes[3] ) << 24;
+        }
+        auto entryField( size_t entry, L::EntryField field ) const -> std::uint32_t {
+            return read( m_data, L::HeaderFields + entry * L::EntryFields + field );
+        }
+        auto nameField( size_t name, size_t field ) const -> std::uint32_t {
+            return read( m_data, L::HeaderFields + m_entryCount * L::EntryFields + name * L::NameFields + field );
+        }
+        auto indexField( size_t position, size_t field ) const -> std::uint32_t {
+            return read( m_data, L::HeaderFields + m_entryCount * L::EntryFields + m_nameCount * L::NameFields + position * L::IndexFields + field );
+        }
+        auto stringAt( std::uint32_t offset, std::uint32_t size ) const -> std::string {
+            return std::string( m_data + offset, size );
+        }
+        auto nameAt( size_t name ) const -> std::string {
+            return stringAt( nameField( name, 0 ), nameField( name, 1 ) );
+        }
+
+        // Every offset is checked once, up front, so nothing needs checking after loading
+        auto isWellFormed( size_t size ) const -> bool;
+
+        auto compareName( size_t name, std::string const &optToken ) const -> int;
+
+    public:
+        static auto load( void const *data, size_t size ) -> BasicResult<SchemaView>;
+
+        // As above, but also rejects a snapshot of any schema other than the expected one
+        static auto load( void const *data, size_t size, std::uint32_t expectedHash ) -> BasicResult<SchemaView>;
+
+        auto hash() const -> std::uint32_t { return read( m_data, L::HashField ); }
+        auto size() const -> size_t { return m_entryCount; }
+        auto slotOf( size_t entry ) const -> std::uint32_t { return entryField( entry, L::Slot ); }
+
+        // Returns the entry with the given option name, or size() if there isn't one
+        auto findOpt( std::string const &optToken ) const -> size_t;
+
+        auto parse( Args const &args, SchemaBindings &bindings ) const -> InternalParseResult;
+
+        auto getHelpColumns() const -> std::vector<HelpColumns>;
+
+        // Writes the option help, as Parser does (but without the usage line)
+        void writeToStream( std::ostream &os ) const {
+            writeHelpRows( os, getHelpColumns() );
+        }
+
+        friend auto operator<<( std::ostream &os, SchemaView const &view ) -> std::ostream& {
+            view.writeToStream( os );
+            return os;
+        }
+    };
+
+    // Definitions of the non-template machinery: inline, unless CLARA_CONFIG_SEPARATE_COMPILATION
+    // is defined - then they are compiled once, into the clara library (src/clara.cpp)
+#if !defined( CLARA_CONFIG_SEPARATE_COMPILATION ) || defined( CLARA_IMPLEMENTATION )
+
+    CLARA_INLINE auto convertByStream( std::string const &source, void *target, void ( *extract )( std::istream &, void * ) ) -> ParserResult {
+        std::stringstream ss;
+        ss << source;
+        extract( ss, target );
+        if( ss.fail() )
+            return ParserResult::runtimeError( "Unable to convert '" + source + "' to destination type" );
+        else
+            return ParserResult::ok( ParseResultType::Matched );
+    }
+
+    CLARA_INLINE auto convertInto( std::string const &source, bool &target ) -> ParserResult {
+        std::string srcLC = source;
+        std::transform( srcLC.begin(), srcLC.end(), srcLC.begin(), []( char c ) { return static_cast<char>( std::tolower(c) ); } );
+        if (srcLC == "y" || srcLC == "1" || srcLC == "true" || srcLC == "yes" || srcLC == "on")
+            target = true;
+        else if (srcLC == "n" || srcLC == "0" || srcLC == "false" || srcLC == "no" || srcLC == "off")
+            target = false;
+        else
+            return ParserResult::runtimeError( "Expected a boolean value but did not recognise: '" + source + "'" );
+        return ParserResult::ok( ParseResultType::Matched );
+    }
+
+    CLARA_INLINE auto parseInteger( char const *first, char const *last, bool isSigned, std::uint64_t max, std::uint64_t &magnitude, bool &negative ) -> ParserResult {
+        auto pos = first;
+        negative = false;
+        if( pos != last && ( *pos == '+' || *pos == '-' ) )
+            negative = *pos++ == '-';
+
+        auto limit = max;
+        if( negative && isSigned )
+            limit += 1;
+
+        magnitude = 0;
+        bool valid = pos != last && ( !negative || isSigned );
+        for( ; valid && pos != last; ++pos ) {
+            auto digit = static_cast<std::uint64_t>( *pos - '0' );
+            valid = *pos >= '0' && *pos <= '9' && magnitude <= ( limit - digit ) / 10;
+            magnitude = magnitude * 10 + digit;
+        }
+        if( !valid )
+            return ParserResult::runtimeError( "Unable to convert '" + std::string( first, last ) + "' to destination type" );
+        return ParserResult::ok( ParseResultType::Matched );
+    }
+
+#if defined( CLARA_CONFIG_PARALLEL_CONVERSION ) || defined( CLARA_CONFIG_PARALLEL_VALIDATION )
+    CLARA_INLINE WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for( auto &worker : m_workers )
+            worker.join();
+    }
+
+    CLARA_INLINE auto WorkerPool::instance() -> WorkerPool & {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    CLARA_INLINE void WorkerPool::work() {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        for(;;) {
+            m_wake.wait( lock, [this] { return m_stopping || !m_tickets.empty(); } );
+            if( m_tickets.empty() )
+                return;
+            auto &job = *m_tickets.front();
+            m_tickets.pop_front();
+            ++job.running;
+            lock.unlock();
+
+            std::exception_ptr exception;
+            try {
+                job.task();
+            }
+            catch( ... ) {
+                exception = std::current_exception();
+            }
+
+            lock.lock();
+            if( exception && !job.exception )
+                job.exception = exception;
+            if( --job.running == 0 )
+                m_finished.notify_all(); // The job may be gone once the lock is released
+        }
+    }
+
+    CLARA_INLINE void WorkerPool::finish( Job &job ) {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_tickets.erase( std::remove( m_tickets.begin(), m_tickets.end(), &job ), m_tickets.end() );
+        m_finished.wait( lock, [&job] { return job.running == 0; } );
+    }
+
+    CLARA_INLINE void WorkerPool::run( size_t threads, std::function<void()> const &task ) {
+        Job job{ task, 0, nullptr };
+        threads = (std::min)( threads, maxThreads() );
+        if( threads > 1 ) {
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                try {
+                    while( m_workers.size() < threads - 1 )
+                        m_workers.emplace_back( [this] { work(); } );
+                }
+                catch( std::system_error const & ) {
+                    // Out of threads - the ones there are (and this one) will do
+                }
+                m_tickets.insert( m_tickets.end(), threads - 1, &job );
+            }
+            m_wake.notify_all();
+        }
+        {
+            // The workers must be done with the job (and whatever task refers to) before it goes,
+            // even if task throws here
+            struct Finish {
+                WorkerPool &pool;
+                Job &job;
+                ~Finish() { pool.finish( job ); }
+            } finish{ *this, job };
+            task();
+        }
+        if( job.exception )
+            std::rethrow_exception( job.exception );
+    }
+#endif
+
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+    CLARA_INLINE auto convertInParallel( std::vector<std::string const *> const &args, size_t threads, void *values,
+                                         auto ( *convert )( std::string const &arg, void *values, size_t index ) -> ParserResult ) -> ParallelConversion {
+        size_t const chunkSize = 1024;
+        auto chunks = ( args.size() + chunkSize - 1 ) / chunkSize;
+        if( threads == 0 )
+            threads = WorkerPool::maxThreads();
+        threads = (std::min)( threads, chunks );
+
+        std::vector<ParserResult> results( chunks, ParserResult::ok( ParseResultType::Matched ) );
+        std::vector<std::exception_ptr> exceptions( chunks );
+        std::vector<size_t> failedAt( chunks );
+        std::atomic<size_t> nextChunk( 0 );
+        std::atomic<size_t> failedChunk( chunks );
+
+        // A conversion that throws fails its chunk like any other, and the exception of the
+        // earliest failing chunk is rethrown once all have finished
+        std::function<void()> convertChunks = [&] {
+            for( auto chunk = nextChunk++; chunk < chunks && chunk < failedChunk; chunk = nextChunk++ ) {
+                auto end = (std::min)( ( chunk + 1 ) * chunkSize, args.size() );
+                for( auto i = chunk * chunkSize; i < end; ++i ) {
+                    auto result = ParserResult::ok( ParseResultType::Matched );
+                    try {
+                        result = convert( *args[i], values, i );
+                    }
+                    catch( ... ) {
+                        exceptions[chunk] = std::current_exception();
+                    }
+                    if( !result || exceptions[chunk] ) {
+                        results[chunk] = result;
+                        failedAt[chunk] = i;
+                        auto failed = failedChunk.load();
+                        while( chunk < failed && !failedChunk.compare_exchange_weak( failed, chunk ) ) {}
+                        break;
+                    }
+                }
+            }
+        };
+        WorkerPool::instance().run( threads, convertChunks );
+
+        auto failed = failedChunk.load();
+        if( failed < chunks ) {
+            if( exceptions[failed] )
+                std::rethrow_exception( exceptions[failed] );
+            return { failedAt[failed], results[failed] };
+        }
+        return { args.size(), ParserResult::ok( ParseResultType::Matched ) };
+    }
+#endif
+
+    CLARA_INLINE auto BoundValue::setValues( ArgIterator first, ArgIterator last ) -> ParserResult {
+        reserve( static_cast<size_t>( last - first ) );
+        return BoundValueRefBase::setValues( first, last );
+    }
+
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+    CLARA_INLINE auto BoundValue::setValuesInParallel( ArgIterator first, ArgIterator last, size_t threads ) -> ParserResult {
+        if( !m_ops.isContainer )
+            return setValues( first, last );
+        std::vector<std::string const *> args;
+        args.reserve( static_cast<size_t>( last - first ) );
+        for( ; first != last; ++first ) {
+            if( !first->empty() )
+                args.push_back( &*first );
+        }
+        return m_ops.setValuesInParallel( m_target, args, threads );
+    }
+#endif
+
+    CLARA_INLINE auto BoundValue::setDelimitedValues( std::string const &arg, char delimiter ) -> ParserResult {
+        if( !m_ops.isContainer )
+            return BoundValueRefBase::setDelimitedValues( arg, delimiter );
+        m_ops.reserve( m_target, static_cast<size_t>( std::count( arg.begin(), arg.end(), delimiter ) ) + 1 );
+        std::string scratch;
+        return forEachDelimited( arg, delimiter, [&]( char const *first, char const *last ) -> ParserResult {
+            return m_ops.setRange( m_target, first, last, scratch );
+        } );
+    }
+
+    CLARA_INLINE void BoundValue::reserve( size_t additional ) {
+        if( m_ops.isContainer )
+            m_ops.reserve( m_target, additional );
+    }
+
+    CLARA_INLINE auto splitCommandLine( std::string const &commandLine ) -> BasicResult<Args> {
+        auto isSpace = []( char c ) { return std::isspace( static_cast<unsigned char>( c ) ) != 0; };
+        std::vector<std::string> words;
+        std::string scratch;
+        auto it = commandLine.begin();
+        auto end = commandLine.end();
+        while( true ) {
+            while( it != end && isSpace( *it ) )
+                ++it;
+            if( it == end )
+                break;
+
+            auto start = it;
+            while( it != end && !isSpace( *it ) && *it != '\'' && *it != '"' && *it != '\\' )
+                ++it;
+            if( it == end || isSpace( *it ) ) {
+                words.emplace_back( start, it );
+                continue;
+            }
+
+            scratch.assign( start, it );
+            bool quoted = false; // Quotes make a word, even an empty one
+            while( it != end && !isSpace( *it ) ) {
+                auto c = *it++;
+                if( c == '\\' ) {
+                    if( it == end )
+                        return BasicResult<Args>::runtimeError( "Command line ends with an incomplete escape" );
+                    if( *it != '\n' ) // Otherwise a line continuation, which is dropped
+                        scratch += *it;
+                    ++it;
+                }
+                else if( c == '\'' ) {
+                    auto close = std::find( it, end, '\'' );
+                    if( close == end )
+                        return BasicResult<Args>::runtimeError( "Unterminated ' quote in command line" );
+                    scratch.append( it, close );
+                    it = close + 1;
+                    quoted = true;
+                }
+                else if( c == '"' ) {
+                    // Within double quotes a backslash only escapes the characters that are otherwise special there
+                    for( ;; ) {
+                        if( it == end )
+                            return BasicResult<Args>::runtimeError( "Unterminated \" quote in command line" );
+                        auto q = *it++;
+                        if( q == '"' )
+                            break;
+                        if( q == '\\' && it != end && ( *it == '"' || *it == '\\' || *it == '$' || *it == '`' || *it == '\n' ) ) {
+                            if( *it != '\n' )
+                                scratch += *it;
+                            ++it;
+                        }
+                        else {
+                            scratch += q;
+                        }
+                    }
+                    quoted = true;
+                }
+                else {
+                    scratch += c;
+                }
+            }
+            if( quoted || !scratch.empty() )
+                words.push_back( scratch );
+        }
+        if( words.empty() )
+            return BasicResult<Args>::runtimeError( "Command line is empty" );
+
+        auto exeName = std::move( words.front() );
+        words.erase( words.begin() );
+        return BasicResult<Args>::ok( Args( std::move( exeName ), std::move( words ) ) );
+    }
+
+    CLARA_INLINE void writeHelpRows( std::ostream &os, std::vector<HelpColumns> const &rows ) {
+        size_t consoleWidth = CLARA_CONFIG_CONSOLE_WIDTH;
+        size_t optWidth = 0;
+        for( auto const &cols : rows )
+            optWidth = (std::max)(optWidth, TextFlow::displayWidth( cols.left ) + 2);
+
+        optWidth = (std::min)(optWidth, consoleWidth/2);
+
+        for( auto const &cols : rows ) {
+            auto row =
+                    TextFlow::Column( cols.left ).width( optWidth ).indent( 2 ) +
+                    TextFlow::Spacer(4) +
+                    TextFlow::Column( cols.right ).width( consoleWidth - 7 - optWidth );
+            os << row << std::endl;
+        }
+    }
+
+    template<typename F>
+    CLARA_INLINE auto TokenTable::classify( ShortValueOpts const &shortValueOpts, F const &addToken ) const -> size_t {
+        size_t tokens = 0;
+        size_t endOfOptions = size_t( -1 );
+        for( size_t source = 0; source < m_args->size(); ++source ) {
+            auto const &arg = (*m_args)[source];
+            if( arg.empty() )
+                continue;
+            if( endOfOptions != size_t( -1 ) || !isOptPrefix( arg[0] ) ) {
+                addToken( TokenType::Argument, source, 0, arg.size() );
+                ++tokens;
+                continue;
+            }
+            if( arg == "--" ) {
+                endOfOptions = tokens;
+                continue;
+            }
+            auto delimiterPos = size_t( findOptDelimiter( arg.data(), arg.data() + arg.size() ) - arg.data() );
+
+            // In a cluster of short options (getopt style), the first that takes a value takes the rest of the
+            // arg as that value, delimiters and all (as in -ofile or -Dname=value) - unless a delimiter follows
+            // the option directly (as in -o=file), in which case the value starts after that
+            size_t valuePos = arg.size();
+            if( arg[1] != '-' ) {
+                valuePos = 1;
+                while( valuePos < delimiterPos && !shortValueOpts.contains( arg[valuePos] ) )
+                    ++valuePos;
+            }
+            if( valuePos < delimiterPos && valuePos + 1 < arg.size() ) {
+                for( size_t pos = 1; pos <= valuePos; ++pos )
+                    addToken( TokenType::Option, source, pos, 1 );
+                auto valueStart = ( valuePos + 1 == delimiterPos ) ? valuePos + 2 : valuePos + 1;
+                addToken( TokenType::Argument, source, valueStart, arg.size() - valueStart );
+                tokens += valuePos + 1;
+            } else if( delimiterPos != arg.size() ) {
+                addToken( TokenType::Option, source, 0, delimiterPos );
+                addToken( TokenType::Argument, source, delimiterPos + 1, arg.size() - delimiterPos - 1 );
+                tokens += 2;
+            } else if( arg[1] != '-' && arg.size() > 2 ) {
+                // A cluster of short options, none of which has its value here
+                for( size_t pos = 1; pos < arg.size(); ++pos )
+                    addToken( TokenType::Option, source, pos, 1 );
+                tokens += arg.size() - 1;
+            } else {
+                addToken( TokenType::Option, source, 0, arg.size() );
+                ++tokens;
+            }
+        }
+        return endOfOptions;
+    }
+
+    CLARA_INLINE auto TokenTable::firstTokenFrom( size_t source ) const -> size_t {
+        return size_t( std::lower_bound( m_sources, m_sources + m_size, source ) - m_sources );
+    }
+
+    CLARA_INLINE void TokenTable::allocateColumns() {
+        auto columns = m_inlineColumns;
+        if( m_size > InlineTokens ) {
+            if( m_size > m_heapCapacity ) {
+                m_heapColumns.reset( new unsigned char[m_size * BytesPerToken] );
+                m_heapCapacity = m_size;
+            }
+            columns = m_heapColumns.get();
+        }
+        // Widest first, so each column is aligned
+        m_texts = reinterpret_cast<std::string const **>( columns );
+        m_sources = reinterpret_cast<std::uint32_t *>( columns + m_size * sizeof( std::string const * ) );
+        m_offsets = m_sources + m_size;
+        m_lengths = m_offsets + m_size;
+        m_types = reinterpret_cast<TokenType *>( m_lengths + m_size );
+    }
+
+    CLARA_INLINE auto TokenTable::copySlice( std::string const &arg, size_t offset, size_t length ) -> std::string const & {
+        if( m_sliceCount == m_slices.size() )
+            m_slices.emplace_back();
+        return m_slices[m_sliceCount++].assign( arg, offset, length );
+    }
+
+    CLARA_INLINE void TokenTable::fill( Args const &args, ShortValueOpts const &shortValueOpts, ParseObserver *observer ) {
+        m_args = &args.m_args;
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+        m_observer = observer;
+#else
+        (void)observer;
+#endif
+        PhaseTimer timer( this->observer(), ParsePhase::Tokenise );
+
+        m_size = 0;
+        size_t copies = 0;
+        classify( shortValueOpts, [&]( TokenType type, size_t source, size_t offset, size_t length ) {
+            ++m_size;
+            if( isCopied( type, (*m_args)[source], offset, length ) )
+                ++copies;
+        } );
+        allocateColumns();
+        m_slices.reserve( copies );
+        m_sliceCount = 0;
+
+        size_t index = 0;
+        size_t bytesCopied = 0;
+        m_endOfOptions = classify( shortValueOpts, [&]( TokenType type, size_t source, size_t offset, size_t length ) {
+            auto const &arg = (*m_args)[source];
+            m_types[index] = type;
+            m_sources[index] = static_cast<std::uint32_t>( source );
+            m_offsets[index] = static_cast<std::uint32_t>( offset );
+            m_lengths[index] = static_cast<std::uint32_t>( length );
+            if( isCopied( type, arg, offset, length ) ) {
+                m_texts[index] = &copySlice( arg, offset, length );
+                bytesCopied += length;
+            } else {
+                m_texts[index] = offset == 0 ? &arg : &shortOptName( arg[offset] );
+            }
+            ++index;
+        } );
+        observeTokensRead( this->observer(), m_size, bytesCopied );
+    }
+
+    CLARA_INLINE auto ExeName::set( std::string const& newName ) -> ParserResult {
+
+        auto lastSlash = newName.find_last_of( "\\/" );
+        auto start = ( lastSlash == std::string::npos ) ? 0 : lastSlash+1;
+
+        // A session sets the same name on every parse, so only copy it when it changes
+        if( newName.compare( start, std::string::npos, *m_name ) != 0 )
+            m_name->assign( newName, start, std::string::npos );
+        if( m_ref )
+            return m_ref->setValue( *m_name );
+        else
+            return ParserResult::ok( ParseResultType::Matched );
+    }
+
+    CLARA_INLINE auto Arg::parse( std::string const &, TokenStream const &tokens ) const -> InternalParseResult {
+        auto validationResult = validate();
+        if( !validationResult )
+            return InternalParseResult( validationResult );
+
+        auto remainingTokens = tokens;
+        auto const &token = *remainingTokens;
+        if( token.type != TokenType::Argument )
+            return InternalParseResult::ok( ParseState( ParseResultType::NoMatch, remainingTokens ) );
+
+        assert( !m_ref->isFlag() );
+        auto valueRef = static_cast<detail::BoundValueRefBase*>( m_ref.get() );
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+        if( m_conversionThreads != 1 && valueRef->isContainer() ) {
+            auto runEnd = remainingTokens.argumentRunEnd();
+            if( runEnd != remainingTokens.argumentRunBegin() ) {
+                auto result = observeConversion( tokens.observer(), *valueRef, [&] {
+                    return setValues( *valueRef, remainingTokens.argumentRunBegin(), runEnd );
+                } );
+                if( !result )
+                    return InternalParseResult( result );
+                return InternalParseResult::ok( ParseState( ParseResultType::Matched, remainingTokens.skipTo( runEnd ) ) );
+            }
+        }
+#endif
+        if( valueRef->isContainer() )
+            valueRef->reserve( remainingTokens.count() );
+
+        auto const &arg = remainingTokens->token;
+        auto result = observeConversion( tokens.observer(), *valueRef, [&] { return valueRef->setValue( arg ); } );
+        if( !result )
+            return InternalParseResult( result );
+        else
+            return InternalParseResult::ok( ParseState( ParseResultType::Matched, ++remainingTokens ) );
+    }
+
+    CLARA_INLINE auto Arg::parseRemaining( TokenStream const &tokens ) const -> InternalParseResult {
+        auto validationResult = validate();
+        if( !validationResult )
+            return InternalParseResult( validationResult );
+
+        assert( tokens.isPastEndOfOptions() );
+        assert( !m_ref->isFlag() );
+        auto valueRef = static_cast<detail::BoundValueRefBase*>( m_ref.get() );
+
+        auto result = observeConversion( tokens.observer(), *valueRef, [&] {
+            return setValues( *valueRef, tokens.remainingArgsBegin(), tokens.remainingArgsEnd() );
+        } );
+        if( !result )
+            return InternalParseResult( result );
+        auto remainingTokens = tokens;
+        return InternalParseResult::ok( ParseState( ParseResultType::Matched, remainingTokens.skipRemaining() ) );
+    }
+
+    CLARA_INLINE auto Opt::getHelpColumns() const -> std::vector<HelpColumns> {
+        std::ostringstream oss;
+        bool first = true;
+        for( auto const &opt : m_optNames ) {
+            if (first)
+                first = false;
+            else
+                oss << ", ";
+            oss << opt;
         }
+        if( !m_hint.empty() )
+            oss << " <" << m_hint << ">";
+
+        auto description = m_description.str();
+        auto values = m_ref->describeValues();
+        if( values.empty() )
+            return { { oss.str(), std::move( description ) } };
+        return { { oss.str(), description.empty() ? "(" + values + ")" : description + " (" + values + ")" } };
+    }
 
-        void writeToStream( std::ostream &os ) const {
-            if (!m_exeName.name().empty()) {
-                os << "usage:\n" << "  " << m_exeName.name() << " ";
-                bool required = true, first = true;
-                for( auto const &arg : m_args ) {
-                    if (first)
-                        first = false;
-                    else
-                        os << " ";
-                    if( arg.isOptional() && required ) {
-                        os << "[";
-                        required = false;
+    CLARA_INLINE auto Opt::parse( std::string const&, TokenStream const &tokens ) const -> InternalParseResult {
+        auto validationResult = validate();
+        if( !validationResult )
+            return InternalParseResult( validationResult );
+
+        auto remainingTokens = tokens;
+        if( remainingTokens && remainingTokens->type == TokenType::Option ) {
+            auto const &token = *remainingTokens;
+            if( isMatch(token.token ) ) {
+                if( m_ref->isFlag() ) {
+                    auto flagRef = static_cast<detail::BoundFlagRefBase*>( m_ref.get() );
+                    auto result = observeConversion( tokens.observer(), *flagRef, [&] { return flagRef->setFlag( true ); } );
+                    if( !result )
+                        return InternalParseResult( result );
+                    if( m_optionalArg ) {
+                        auto argTokens = remainingTokens;
+                        ++argTokens;
+                        if( argTokens && argTokens->type == TokenType::Argument ) {
+                            auto argResult = m_optionalArg->setValue( argTokens->token );
+                            if( !argResult )
+                                return InternalParseResult( argResult );
+                            remainingTokens = argTokens;
+                        }
                     }
-                    os << "<" << arg.hint() << ">";
-                    if( arg.cardinality() == 0 )
-                        os << " ... ";
+                    if( result.value() == ParseResultType::ShortCircuitAll )
+                        return InternalParseResult::ok( ParseState( result.value(), remainingTokens ) );
+                } else {
+                    auto valueRef = static_cast<detail::BoundValueRefBase*>( m_ref.get() );
+                    ++remainingTokens;
+                    if( !remainingTokens )
+                        return InternalParseResult::runtimeError( "Expected argument following " + token.token );
+                    auto const &argToken = *remainingTokens;
+                    if( argToken.type != TokenType::Argument )
+                        return InternalParseResult::runtimeError( "Expected argument following " + token.token );
+                    auto result = observeConversion( tokens.observer(), *valueRef, [&] {
+                        return m_delimiter != '\0'
+                            ? valueRef->setDelimitedValues( argToken.token, m_delimiter )
+                            : valueRef->setValue( argToken.token );
+                    } );
+                    if( !result )
+                        return InternalParseResult( result );
+                    if( result.value() == ParseResultType::ShortCircuitAll )
+                        return InternalParseResult::ok( ParseState( result.value(), remainingTokens ) );
                 }
-                if( !required )
-                    os << "]";
-                if( !m_options.empty() )
-                    os << " options";
-                os << "\n\nwhere options are:" << std::endl;
+                return InternalParseResult::ok( ParseState( ParseResultType::Matched, ++remainingTokens ) );
             }
+        }
+        return InternalParseResult::ok( ParseState( ParseResultType::NoMatch, remainingTokens ) );
+    }
 
-            auto rows = getHelpColumns();
-            size_t consoleWidth = CLARA_CONFIG_CONSOLE_WIDTH;
-            size_t optWidth = 0;
-            for( auto const &cols : rows )
-                optWidth = (std::max)(optWidth, cols.left.size() + 2);
+    CLARA_INLINE void Opt::addShortValueOpts( ShortValueOpts &shortValueOpts ) const {
+        if( isFlag() )
+            return;
+        for( auto const &name : m_optNames ) {
+            if( name.size() == 2 ) // Only short names matter, and they copy without allocating
+                shortValueOpts.add( normaliseOpt( name.str() ) );
+        }
+    }
 
-            optWidth = (std::min)(optWidth, consoleWidth/2);
+    CLARA_INLINE auto Opt::validate() const -> Result {
+        if( m_optNames.empty() )
+            return Result::logicError( "No options supplied to Opt" );
+        for( auto const &name : m_optNames ) {
+            if( name.empty() )
+                return Result::logicError( "Option name cannot be empty" );
+#ifdef CLARA_PLATFORM_WINDOWS
+            if( name[0] != '-' && name[0] != '/' )
+                return Result::logicError( "Option name must begin with '-' or '/'" );
+#else
+            if( name[0] != '-' )
+                return Result::logicError( "Option name must begin with '-'" );
+#endif
+        }
+        if( m_delimiter != '\0' && m_ref->isFlag() )
+            return Result::logicError( "Flags cannot take a delimited list" );
+        if( m_validator && m_ref->isFlag() )
+            return Result::logicError( "Flags cannot have a validator" );
+        return ParserRefImpl::validate();
+    }
 
-            for( auto const &cols : rows ) {
-                auto row =
-                        TextFlow::Column( cols.left ).width( optWidth ).indent( 2 ) +
-                        TextFlow::Spacer(4) +
-                        TextFlow::Column( cols.right ).width( consoleWidth - 7 - optWidth );
-                os << row << std::endl;
+    template<typename F>
+    CLARA_INLINE void HelpIndex::forEachWord( std::string const &text, F const &f ) {
+        std::string word;
+        for( auto c : text ) {
+            if( std::isalnum( static_cast<unsigned char>( c ) ) ) {
+                word += static_cast<char>( std::tolower( static_cast<unsigned char>( c ) ) );
+            }
+            else if( !word.empty() ) {
+                f( word );
+                word.clear();
             }
         }
+        if( !word.empty() )
+            f( word );
+    }
 
-        friend auto operator<<( std::ostream &os, Parser const &parser ) -> std::ostream& {
-            parser.writeToStream( os );
-            return os;
+    CLARA_INLINE void HelpIndex::mergePostings( std::vector<Posting> &postings ) {
+        std::sort( postings.begin(), postings.end(), []( Posting const &lhs, Posting const &rhs ) {
+            return lhs.row < rhs.row || ( lhs.row == rhs.row && lhs.score > rhs.score );
+        } );
+        postings.erase( std::unique( postings.begin(), postings.end(), []( Posting const &lhs, Posting const &rhs ) {
+            return lhs.row == rhs.row;
+        } ), postings.end() );
+    }
+
+    CLARA_INLINE auto HelpIndex::termsMatching( std::string const &word ) const -> TermRange {
+        auto first = std::lower_bound( m_terms.begin(), m_terms.end(), word, []( Term const &term, std::string const &w ) {
+            return term.word < w;
+        } );
+        auto last = first;
+        while( last != m_terms.end() && last->word.compare( 0, word.size(), word ) == 0 )
+            ++last;
+        return { first, last };
+    }
+
+    CLARA_INLINE HelpIndex::HelpIndex( std::vector<HelpColumns> rows ) : m_rows( std::move( rows ) ) {
+        enum : std::uint32_t { DescriptionScore = 1, NameScore = 4 };
+
+        std::vector<std::pair<std::string, Posting>> occurrences;
+        for( std::uint32_t row = 0; row < m_rows.size(); ++row ) {
+            forEachWord( m_rows[row].left, [&]( std::string const &word ) {
+                occurrences.push_back( { word, { row, NameScore } } );
+            } );
+            forEachWord( m_rows[row].right, [&]( std::string const &word ) {
+                occurrences.push_back( { word, { row, DescriptionScore } } );
+            } );
+        }
+        std::sort( occurrences.begin(), occurrences.end(), []( std::pair<std::string, Posting> const &lhs, std::pair<std::string, Posting> const &rhs ) {
+            return lhs.first < rhs.first;
+        } );
+        for( auto const &occurrence : occurrences ) {
+            if( m_terms.empty() || m_terms.back().word != occurrence.first )
+                m_terms.push_back( { occurrence.first, {} } );
+            m_terms.back().postings.push_back( occurrence.second );
         }
+        for( auto &term : m_terms )
+            mergePostings( term.postings );
+    }
 
-        auto validate() const -> Result override {
-            for( auto const &opt : m_options ) {
-                auto result = opt.validate();
-                if( !result )
-                    return result;
+    CLARA_INLINE auto HelpIndex::search( std::string const &query ) const -> std::vector<HelpColumns> {
+        std::vector<std::pair<std::string, TermRange>> words;
+        forEachWord( query, [&]( std::string const &word ) {
+            words.push_back( { word, termsMatching( word ) } );
+        } );
+        if( words.empty() )
+            return m_rows;
+
+        auto matchCount = []( TermRange const &range ) {
+            size_t count = 0;
+            for( auto it = range.first; it != range.second; ++it )
+                count += it->postings.size();
+            return count;
+        };
+        std::vector<size_t> counts;
+        for( auto const &word : words )
+            counts.push_back( matchCount( word.second ) );
+        auto rarest = static_cast<size_t>( std::min_element( counts.begin(), counts.end() ) - counts.begin() );
+
+        std::vector<Posting> results;
+        for( auto it = words[rarest].second.first; it != words[rarest].second.second; ++it ) {
+            for( auto const &posting : it->postings )
+                results.push_back( { posting.row, scoreOf( words[rarest].first, *it, posting ) } );
+        }
+        mergePostings( results );
+
+        for( size_t i = 0; i < words.size() && !results.empty(); ++i ) {
+            if( i == rarest )
+                continue;
+            std::vector<Posting> both;
+            for( auto const &result : results ) {
+                std::uint32_t best = 0;
+                for( auto it = words[i].second.first; it != words[i].second.second; ++it ) {
+                    auto posting = std::lower_bound( it->postings.begin(), it->postings.end(), result.row, []( Posting const &p, std::uint32_t row ) {
+                        return p.row < row;
+                    } );
+                    if( posting != it->postings.end() && posting->row == result.row )
+                        best = (std::max)( best, scoreOf( words[i].first, *it, *posting ) );
+                }
+                if( best != 0 )
+                    both.push_back( { result.row, result.score + best } );
             }
+            results = std::move( both );
+        }
+
+        std::stable_sort( results.begin(), results.end(), []( Posting const &lhs, Posting const &rhs ) {
+            return lhs.score > rhs.score;
+        } );
+        std::vector<HelpColumns> rows;
+        rows.reserve( results.size() );
+        for( auto const &result : results )
+            rows.push_back( m_rows[result.row] );
+        return rows;
+    }
+
+    struct LazyHelpIndex::State {
+        std::mutex mutex;
+        std::shared_ptr<HelpIndex const> index;
+    };
+
+    // Guards the creation of every LazyHelpIndex's State - held only to create or read the pointer
+    inline auto helpIndexStateMutex() -> std::mutex & {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    CLARA_INLINE LazyHelpIndex::LazyHelpIndex() {}
+    CLARA_INLINE LazyHelpIndex::LazyHelpIndex( LazyHelpIndex const &other ) {
+        if( auto index = other.load() )
+            createdState().index = std::move( index );
+    }
+    CLARA_INLINE auto LazyHelpIndex::operator=( LazyHelpIndex const &other ) -> LazyHelpIndex & {
+        auto index = other.load();
+        if( !index && !existingState() )
+            return *this;
+        auto &state = createdState();
+        std::lock_guard<std::mutex> lock( state.mutex );
+        state.index = std::move( index );
+        return *this;
+    }
+    CLARA_INLINE LazyHelpIndex::~LazyHelpIndex() {}
+
+    CLARA_INLINE auto LazyHelpIndex::existingState() const -> State * {
+        std::lock_guard<std::mutex> lock( helpIndexStateMutex() );
+        return m_state.get();
+    }
+    CLARA_INLINE auto LazyHelpIndex::createdState() -> State & {
+        std::lock_guard<std::mutex> lock( helpIndexStateMutex() );
+        if( !m_state )
+            m_state.reset( new State );
+        return *m_state;
+    }
+
+    CLARA_INLINE auto LazyHelpIndex::load() const -> std::shared_ptr<HelpIndex const> {
+        auto state = existingState();
+        if( !state )
+            return {};
+        std::lock_guard<std::mutex> lock( state->mutex );
+        return state->index;
+    }
+
+    CLARA_INLINE auto LazyHelpIndex::get( std::function<std::vector<HelpColumns>()> const &buildRows ) -> std::shared_ptr<HelpIndex const> {
+        auto &state = createdState();
+        std::lock_guard<std::mutex> lock( state.mutex );
+        if( !state.index )
+            state.index = std::make_shared<HelpIndex const>( buildRows() );
+        return state.index;
+    }
+
+    CLARA_INLINE void LazyHelpIndex::reset() {
+        auto state = existingState();
+        if( !state )
+            return;
+        std::lock_guard<std::mutex> lock( state->mutex );
+        state->index.reset();
+    }
+
+    CLARA_INLINE auto OptConstraint::isViolatedBy( OptionSet const &seen ) const -> bool {
+        auto given = options.countIn( seen );
+        switch( kind ) {
+            case ConstraintKind::Exclusive: return given > 1;
+            case ConstraintKind::AtLeastOne: return given == 0;
+            case ConstraintKind::AllOrNone: return given != 0 && given != options.count();
+            case ConstraintKind::DependsOn: return dependents.countIn( seen ) != 0 && given != options.count();
+        }
+        return false;
+    }
+
+    CLARA_INLINE auto OptConstraint::describeViolation() const -> std::string {
+        std::string list;
+        for( auto it = names.begin() + ( kind == ConstraintKind::DependsOn ? 1 : 0 ); it != names.end(); ++it )
+            list += ( list.empty() ? "" : ", " ) + *it;
+        switch( kind ) {
+            case ConstraintKind::Exclusive: return "Only one of " + list + " may be given";
+            case ConstraintKind::AtLeastOne: return "One of " + list + " is required";
+            case ConstraintKind::AllOrNone: return list + " must be given together";
+            case ConstraintKind::DependsOn: return names.front() + " requires " + list;
+        }
+        return list;
+    }
+
+    CLARA_INLINE auto Parser::constrain( ConstraintKind kind, std::vector<std::string> const &names ) -> Parser & {
+        OptConstraint constraint{ kind, names, OptionSet(), OptionSet(), std::string() };
+        for( size_t i = 0; i < names.size() && constraint.error.empty(); ++i ) {
+            auto index = findOption( names[i] );
+            if( index == m_options.size() )
+                constraint.error = "Unknown option in constraint: " + names[i];
+            else if( kind == ConstraintKind::DependsOn && i == 0 )
+                constraint.dependents.add( index );
+            else
+                constraint.options.add( index );
+        }
+        m_constraints.push_back( constraint );
+        return *this;
+    }
+
+    CLARA_INLINE auto Parser::findOption( std::string const &name ) const -> size_t {
+#ifdef CLARA_PLATFORM_WINDOWS
+        if( !name.empty() && name[0] == '/' )
+            return findOption( normaliseOpt( name ) ); // Once, rather than in each isMatch
+#endif
+        for( size_t i = 0; i < m_options.size(); ++i ) {
+            if( m_options[i].isMatch( name ) )
+                return i;
+        }
+        return m_options.size();
+    }
+
+    CLARA_INLINE auto Parser::getHelpColumns() const -> std::vector<HelpColumns> {
+        std::vector<HelpColumns> cols;
+        for (auto const &o : m_options) {
+            if( o.isHidden() )
+                continue;
+            auto childCols = o.getHelpColumns();
+            cols.insert( cols.end(), childCols.begin(), childCols.end() );
+        }
+        return cols;
+    }
+
+    CLARA_INLINE void Parser::writeToStream( std::ostream &os ) const {
+        if (!m_exeName.name().empty()) {
+            os << "usage:\n" << "  " << m_exeName.name() << " ";
+            bool required = true, first = true;
             for( auto const &arg : m_args ) {
-                auto result = arg.validate();
-                if( !result )
-                    return result;
+                if( arg.isHidden() )
+                    continue;
+                if (first)
+                    first = false;
+                else
+                    os << " ";
+                if( arg.isOptional() && required ) {
+                    os << "[";
+                    required = false;
+                }
+                os << "<" << arg.hint() << ">";
+                if( arg.cardinality() == 0 )
+                    os << " ... ";
             }
-            return Result::ok();
+            if( !required )
+                os << "]";
+            if( !m_options.empty() )
+                os << " options";
+            os << "\n\nwhere options are:" << std::endl;
         }
 
-        using ParserBase::parse;
+        writeHelpRows( os, getHelpColumns() );
+    }
 
-        auto parse( std::string const& exeName, TokenStream const &tokens ) const -> InternalParseResult override {
+    CLARA_INLINE auto Parser::search( std::string const &query ) const -> std::vector<HelpColumns> {
+        return m_helpIndex.get( [this] { return getHelpColumns(); } )->search( query );
+    }
 
-            struct ParserInfo {
-                ParserBase const* parser = nullptr;
-                size_t count = 0;
-            };
-            const size_t totalParsers = m_options.size() + m_args.size();
-            assert( totalParsers < 512 );
-            // ParserInfo parseInfos[totalParsers]; // <-- this is what we really want to do
-            ParserInfo parseInfos[512];
+    CLARA_INLINE auto Parser::validate() const -> Result {
+        for( auto const &opt : m_options ) {
+            auto result = opt.validate();
+            if( !result )
+                return result;
+        }
+        for( auto const &arg : m_args ) {
+            auto result = arg.validate();
+            if( !result )
+                return result;
+        }
+        for( auto const &constraint : m_constraints ) {
+            if( !constraint.error.empty() )
+                return Result::logicError( constraint.error );
+        }
+        return Result::ok();
+    }
 
-            {
-                size_t i = 0;
-                for (auto const &opt : m_options) parseInfos[i++].parser = &opt;
-                for (auto const &arg : m_args) parseInfos[i++].parser = &arg;
+    CLARA_INLINE auto Parser::shortValueOpts() const -> ShortValueOpts {
+        ShortValueOpts shortValueOpts;
+        for( auto const &opt : m_options )
+            opt.addShortValueOpts( shortValueOpts );
+        return shortValueOpts;
+    }
+
+    CLARA_INLINE auto Parser::parse( Args const &args ) const -> InternalParseResult {
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+        PhaseTimer timer( m_observer, ParsePhase::Total );
+        TokenTable table( args, shortValueOpts(), m_observer );
+#else
+        TokenTable table( args, shortValueOpts() );
+#endif
+        return detachTokens( parse( args.exeName(), TokenStream( table ) ) );
+    }
+
+    CLARA_INLINE auto Parser::parseCollectingErrors( Args const &args ) const -> DiagnosticsResult {
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+        PhaseTimer timer( m_observer, ParsePhase::Total );
+        TokenTable table( args, shortValueOpts(), m_observer );
+#else
+        TokenTable table( args, shortValueOpts() );
+#endif
+        std::vector<Diagnostic> diagnostics;
+        auto result = parseTokens( args.exeName(), TokenStream( table ).unbatched(), &diagnostics );
+        if( !result )
+            return DiagnosticsResult( result );
+        return DiagnosticsResult::ok( std::move( diagnostics ) );
+    }
+
+    CLARA_INLINE auto Parser::recoverFrom( size_t i, TokenStream const &tokens, std::string const &message, std::vector<Diagnostic> &diagnostics ) const -> TokenStream {
+        auto next = tokens;
+        ++next;
+        auto kind = DiagnosticKind::ConversionFailed;
+        auto atFault = tokens; // For an option that takes a value, the value that failed to convert
+        if( i < m_options.size() && !m_options[i].isFlag() ) {
+            if( next && next->type == TokenType::Argument ) {
+                atFault = next;
+                ++next;
             }
+            else
+                kind = DiagnosticKind::MissingArgument;
+        }
+        diagnostics.push_back( { kind, atFault.index(), atFault.argIndex(), message } );
+        return next;
+    }
 
-            m_exeName.set( exeName );
+    CLARA_INLINE auto Parser::parseTokens( std::string const& exeName, TokenStream const &tokens, std::vector<Diagnostic> *diagnostics ) const -> InternalParseResult {
 
-            auto result = InternalParseResult::ok( ParseState( ParseResultType::NoMatch, tokens ) );
-            while( result.value().remainingTokens() ) {
-                bool tokenParsed = false;
+        struct ParserInfo {
+            ParserBase const* parser = nullptr;
+            size_t count = 0;
+        };
+        const size_t totalParsers = m_options.size() + m_args.size();
+        // ParserInfo parseInfos[totalParsers]; // <-- this is what we really want to do
+        // Most parsers fit on the stack - larger ones go on the heap
+        ParserInfo localInfos[512];
+        std::unique_ptr<ParserInfo[]> heapInfos;
+        if( totalParsers > 512 )
+            heapInfos.reset( new ParserInfo[totalParsers] );
+        auto parseInfos = heapInfos ? heapInfos.get() : localInfos;
+
+        {
+            size_t i = 0;
+            for (auto const &opt : m_options) parseInfos[i++].parser = &opt;
+            for (auto const &arg : m_args) parseInfos[i++].parser = &arg;
+        }
 
-                for( size_t i = 0; i < totalParsers; ++i ) {
-                    auto&  parseInfo = parseInfos[i];
-                    if( parseInfo.parser->cardinality() == 0 || parseInfo.count < parseInfo.parser->cardinality() ) {
-                        result = parseInfo.parser->parse(exeName, result.value().remainingTokens());
-                        if (!result)
+        m_exeName.set( exeName );
+
+        OptionSet seen( m_constraints.empty() ? 0 : m_options.size() );
+        std::vector<PendingValidation> pending;
+        auto result = InternalParseResult::ok( ParseState( ParseResultType::NoMatch, tokens ) );
+        while( result.value().remainingTokens() ) {
+            auto const current = result.value().remainingTokens();
+            bool tokenParsed = false;
+
+            // After "--" only Args can match, so if the next Arg to be filled is variadic
+            // it takes all the remaining tokens - in bulk (unless errors are being collected, token by token)
+            if( !diagnostics && current.isPastEndOfOptions() ) {
+                auto i = m_options.size();
+                while( i < totalParsers && parseInfos[i].parser->cardinality() != 0 && parseInfos[i].count >= parseInfos[i].parser->cardinality() )
+                    ++i;
+                if( i < totalParsers && parseInfos[i].parser->cardinality() == 0 ) {
+                    result = m_args[i - m_options.size()].parseRemaining( current );
+                    if( !result )
+                        return result;
+                    queueValidations( i, current, result.value().remainingTokens(), pending );
+                    ++parseInfos[i].count;
+                    continue;
+                }
+            }
+
+            size_t attempts = 0;
+            for( size_t i = 0; i < totalParsers; ++i ) {
+                auto&  parseInfo = parseInfos[i];
+                if( parseInfo.parser->cardinality() == 0 || parseInfo.count < parseInfo.parser->cardinality() ) {
+                    ++attempts;
+                    result = parseInfo.parser->parse(exeName, current);
+                    auto const parsed = static_cast<bool>( result );
+                    if (!result) {
+                        if( !diagnostics || result.type() == ResultBase::LogicError )
                             return result;
-                        if (result.value().type() != ParseResultType::NoMatch) {
-                            tokenParsed = true;
-                            ++parseInfo.count;
-                            break;
-                        }
+                        auto next = recoverFrom( i, current, result.errorMessage(), *diagnostics );
+                        result = InternalParseResult::ok( ParseState( ParseResultType::Matched, next ) );
+                    }
+                    if (result.value().type() != ParseResultType::NoMatch) {
+                        if( parsed )
+                            queueValidations( i, current, result.value().remainingTokens(), pending );
+                        tokenParsed = true;
+                        ++parseInfo.count;
+                        if( i < m_options.size() && !m_constraints.empty() )
+                            seen.add( i );
+                        break;
+                    }
+                }
+            }
+            observeTokenDispatched( tokens.observer(), attempts );
+
+            if( result.value().type() == ParseResultType::ShortCircuitAll )
+                return result;
+            if( !tokenParsed ) {
+                auto message = "Unrecognised token: " + current->token;
+                if( !diagnostics )
+                    return InternalParseResult::runtimeError( message );
+                diagnostics->push_back( { DiagnosticKind::UnrecognisedToken, current.index(), current.argIndex(), message } );
+                auto next = current;
+                result = InternalParseResult::ok( ParseState( ParseResultType::NoMatch, ++next ) );
+            }
+        }
+        // !TBD Check missing required options (outside of collecting errors)
+        if( diagnostics ) {
+            auto const &end = result.value().remainingTokens();
+            for( size_t i = 0; i < m_options.size(); ++i ) {
+                if( !m_options[i].isOptional() && parseInfos[i].count == 0 )
+                    diagnostics->push_back( { DiagnosticKind::MissingRequired, end.index(), end.argIndex(), "Missing required option: " + m_options[i].optNames().front().str() } );
+            }
+            for( size_t i = 0; i < m_args.size(); ++i ) {
+                if( !m_args[i].isOptional() && parseInfos[m_options.size() + i].count == 0 )
+                    diagnostics->push_back( { DiagnosticKind::MissingRequired, end.index(), end.argIndex(), "Missing required argument: <" + m_args[i].hint() + ">" } );
+            }
+        }
+
+        std::string violations;
+        for( auto const &constraint : m_constraints ) {
+            if( !constraint.error.empty() )
+                return InternalParseResult::logicError( constraint.error );
+            if( constraint.isViolatedBy( seen ) ) {
+                if( diagnostics ) {
+                    auto const &end = result.value().remainingTokens();
+                    diagnostics->push_back( { DiagnosticKind::ConstraintViolated, end.index(), end.argIndex(), constraint.describeViolation() } );
+                }
+                else {
+                    violations += ( violations.empty() ? "" : "\n" ) + constraint.describeViolation();
+                }
+            }
+        }
+        if( !violations.empty() )
+            return InternalParseResult::runtimeError( violations );
+
+        if( !pending.empty() ) {
+            auto validated = validateValues( pending, tokens.observer(), diagnostics );
+            if( !validated )
+                return validated;
+        }
+        return result;
+    }
+
+    CLARA_INLINE void Parser::queueValidations( size_t i, TokenStream first, TokenStream const &last, std::vector<PendingValidation> &pending ) const {
+        auto const &validator = i < m_options.size() ? m_options[i].validator() : m_args[i - m_options.size()].validator();
+        if( !validator )
+            return;
+        for( ; first.index() < last.index(); ++first ) {
+            if( first->type == TokenType::Argument )
+                pending.push_back( { &validator, &first->token, first.index(), first.argIndex() } );
+        }
+    }
+
+    CLARA_INLINE auto Parser::validateValues( std::vector<PendingValidation> const &pending, ParseObserver *observer, std::vector<Diagnostic> *diagnostics ) const -> InternalParseResult {
+        PhaseTimer timer( observer, ParsePhase::Validate );
+#ifdef CLARA_CONFIG_PARALLEL_VALIDATION
+        auto results = runValidations( pending, m_validationThreads );
+#else
+        auto results = runValidations( pending, 1 );
+#endif
+        std::string errors;
+        for( size_t i = 0; i < results.size(); ++i ) {
+            if( results[i] )
+                continue;
+            if( diagnostics )
+                diagnostics->push_back( { DiagnosticKind::ValidationFailed, pending[i].token, pending[i].arg, results[i].errorMessage() } );
+            else
+                errors += ( errors.empty() ? "" : "\n" ) + results[i].errorMessage();
+        }
+        if( !errors.empty() )
+            return InternalParseResult::runtimeError( errors );
+        return InternalParseResult::ok( ParseState( ParseResultType::Matched, TokenStream() ) );
+    }
+
+    CLARA_INLINE auto runValidations( std::vector<PendingValidation> const &pending, size_t threads ) -> std::vector<ParserResult> {
+        std::vector<ParserResult> results( pending.size(), ParserResult::ok( ParseResultType::Matched ) );
+#ifdef CLARA_CONFIG_PARALLEL_VALIDATION
+        if( threads == 0 )
+            threads = WorkerPool::maxThreads();
+        threads = (std::min)( threads, pending.size() );
+        if( threads > 1 ) {
+            // Each thread claims the next value in turn. Exceptions are held until all have finished,
+            // then the first, in token order, is rethrown - as if the validators had been called in turn
+            std::vector<std::exception_ptr> exceptions( pending.size() );
+            std::atomic<size_t> next( 0 );
+            std::function<void()> validateNext = [&] {
+                for( auto i = next++; i < pending.size(); i = next++ ) {
+                    try {
+                        results[i] = ( *pending[i].validator )( *pending[i].value );
+                    }
+                    catch( ... ) {
+                        exceptions[i] = std::current_exception();
                     }
                 }
+            };
+            WorkerPool::instance().run( threads, validateNext );
+            for( auto const &exception : exceptions ) {
+                if( exception )
+                    std::rethrow_exception( exception );
+            }
+            return results;
+        }
+#else
+        (void)threads;
+#endif
+        for( size_t i = 0; i < pending.size(); ++i )
+            results[i] = ( *pending[i].validator )( *pending[i].value );
+        return results;
+    }
 
-                if( result.value().type() == ParseResultType::ShortCircuitAll )
-                    return result;
-                if( !tokenParsed )
-                    return InternalParseResult::runtimeError( "Unrecognised token: " + result.value().remainingTokens()->token );
+    CLARA_INLINE ParseSession::ParseSession( Parser const &parser )
+    :   m_parser( parser ),
+        m_shortValueOpts( parser.shortValueOpts() )
+    {
+        for( auto const &opt : m_parser.m_options )
+            opt.captureDefaults( m_defaults );
+        for( auto const &arg : m_parser.m_args )
+            arg.captureDefaults( m_defaults );
+    }
+
+    CLARA_INLINE auto ParseSession::parse( Args const &args ) -> InternalParseResult {
+        reset();
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+        PhaseTimer timer( m_parser.m_observer, ParsePhase::Total );
+        m_tokens.fill( args, m_shortValueOpts, m_parser.m_observer );
+#else
+        m_tokens.fill( args, m_shortValueOpts );
+#endif
+        return detachTokens( m_parser.parse( args.exeName(), TokenStream( m_tokens ) ) );
+    }
+
+    CLARA_INLINE auto CompletionIndex::findOpt( std::string const &name ) const -> Opt const * {
+        auto it = std::lower_bound( m_entries.begin(), m_entries.end(), Entry{ name, 0 } );
+        if( it == m_entries.end() || it->name != name )
+            return nullptr;
+        return m_opts[it->opt];
+    }
+
+    CLARA_INLINE void CompletionIndex::addOptNames( std::string const &prefix, CompletionResult &result ) const {
+        auto it = std::lower_bound( m_entries.begin(), m_entries.end(), Entry{ prefix, 0 } );
+        for( ; it != m_entries.end() && it->name.compare( 0, prefix.size(), prefix ) == 0; ++it )
+            result.candidates.push_back( { it->name, m_opts[it->opt]->description() } );
+    }
+
+    CLARA_INLINE void CompletionIndex::addValues( Opt const &opt, std::string const &prefix, std::string const &valuePrefix, CompletionResult &result ) {
+        if( opt.isFlag() )
+            return;
+        result.hint = opt.hint();
+        for( auto const &value : opt.valueNames() ) {
+            if( value.compare( 0, valuePrefix.size(), valuePrefix ) == 0 )
+                result.candidates.push_back( { prefix + value, {} } );
+        }
+        std::sort( result.candidates.begin(), result.candidates.end(), []( Completion const &lhs, Completion const &rhs ) {
+            return lhs.value < rhs.value;
+        } );
+    }
+
+    CLARA_INLINE CompletionIndex::CompletionIndex( Parser const &parser ) {
+        m_opts.reserve( parser.m_options.size() );
+        for( auto const &opt : parser.m_options ) {
+            if( opt.isHidden() )
+                continue;
+            for( auto const &name : opt.optNames() )
+                m_entries.push_back( { normaliseOpt( name.str() ), m_opts.size() } );
+            m_opts.push_back( &opt );
+        }
+        std::sort( m_entries.begin(), m_entries.end() );
+    }
+
+    CLARA_INLINE auto CompletionIndex::complete( std::vector<std::string> const &words, size_t cursor ) const -> CompletionResult {
+        CompletionResult result;
+        if( cursor == 0 || cursor > words.size() )
+            return result;
+        for( size_t i = 1; i < cursor; ++i ) {
+            if( words[i] == "--" )
+                return result; // Only positional arguments from here on
+        }
+
+        auto current = cursor < words.size() ? normaliseOpt( words[cursor] ) : std::string();
+        if( isOptPrefix( current[0] ) ) {
+            auto delimiterPos = current.find_first_of( " :=" );
+            if( delimiterPos == std::string::npos ) {
+                addOptNames( current, result );
+            } else if( auto opt = findOpt( current.substr( 0, delimiterPos ) ) ) {
+                addValues( *opt, current.substr( 0, delimiterPos + 1 ), current.substr( delimiterPos + 1 ), result );
             }
-            // !TBD Check missing required options
             return result;
         }
-    };
+        if( cursor > 1 ) {
+            if( auto opt = findOpt( normaliseOpt( words[cursor - 1] ) ) )
+                addValues( *opt, {}, current, result );
+        }
+        return result;
+    }
 
-    template<typename DerivedT>
-    template<typename T>
-    auto ComposableParserImpl<DerivedT>::operator|( T const &other ) const -> Parser {
-        return Parser() | static_cast<DerivedT const &>( *this ) | other;
+    CLARA_INLINE auto CompletionIndex::handleRequest( Args const &args, std::ostream &os ) const -> bool {
+        if( !isRequest( args ) )
+            return false;
+        if( args.m_args.size() < 2 )
+            return true; // A malformed request - nothing to complete
+        std::vector<std::string> words( args.m_args.begin() + 2, args.m_args.end() );
+        size_t cursor = 0;
+        for( auto c : args.m_args[1] ) {
+            // The cursor can be at most one past the last word, which also keeps this from overflowing
+            if( !std::isdigit( static_cast<unsigned char>( c ) ) || cursor > words.size() )
+                return true; // A malformed request - nothing to complete
+            cursor = cursor * 10 + static_cast<size_t>( c - '0' );
+        }
+        for( auto const &candidate : complete( words, cursor ).candidates )
+            os << candidate.value << '\t' << candidate.description << '\n';
+        return true;
+    }
+
+    CLARA_INLINE auto handleCompletionRequest( Parser const &parser, Args const &args, std::ostream &os ) -> bool {
+        if( !CompletionIndex::isRequest( args ) )
+            return false;
+        return CompletionIndex( parser ).handleRequest( args, os );
+    }
+
+    // Whether the name can go in a completion script as it is: nothing in it that any of the shells treats specially
+    inline auto isPlainShellWord( std::string const &word ) -> bool {
+        for( auto c : word ) {
+            if( !std::isalnum( static_cast<unsigned char>( c ) ) && ( c == '\0' || std::strchr( "_-.+/", c ) == nullptr ) )
+                return false;
+        }
+        return !word.empty();
     }
+
+    // The word in single quotes, if it needs them. Fish also takes backslash escapes within them
+    inline auto quoteShellWord( std::string const &word, Shell shell ) -> std::string {
+        if( isPlainShellWord( word ) )
+            return word;
+        std::string quoted = "'";
+        for( auto c : word ) {
+            if( shell == Shell::Fish && ( c == '\\' || c == '\'' ) )
+                quoted += { '\\', c };
+            else if( c == '\'' )
+                quoted += "'\\''";
+            else
+                quoted += c;
+        }
+        return quoted + "'";
+    }
+
+    CLARA_INLINE auto completionScript( Shell shell, std::string const &exeName ) -> std::string {
+        std::string function = "_";
+        for( auto c : exeName )
+            function += std::isalnum( static_cast<unsigned char>( c ) ) ? c : '_';
+        function += "_clara_complete";
+
+        std::string request = CompletionIndex::requestOption();
+        auto name = quoteShellWord( exeName, shell );
+        switch( shell ) {
+        case Shell::Bash:
+            return
+                // The shell has already split the line into COMP_WORDS, respecting quotes, but also
+                // at COMP_WORDBREAKS - so an '=' is joined back up with the words either side of it
+                function + "() {\n"
+                "    local -a words candidates\n"
+                "    local i cword=0 candidate IFS=$'\\n'\n"
+                "    for (( i = 0; i < ${#COMP_WORDS[@]}; ++i )); do\n"
+                "        if (( i > 0 )) && [[ \"${COMP_WORDS[i]}\" == = || \"${COMP_WORDS[i-1]}\" == = ]]; then\n"
+                "            words[${#words[@]}-1]+=\"${COMP_WORDS[i]}\"\n"
+                "        else\n"
+                "            words+=( \"${COMP_WORDS[i]}\" )\n"
+                "        fi\n"
+                "        (( i == COMP_CWORD )) && cword=$(( ${#words[@]} - 1 ))\n"
+                "    done\n"
+                // Read line by line, rather than split from a command substitution, which would expand
+                // any candidate that is a glob (such as -?) into the matching file names
+                "    mapfile -t candidates < <(\"${words[0]}\" " + request + " \"$cword\" \"${words[@]}\" 2>/dev/null | cut -f1)\n"
+                "    COMPREPLY=()\n"
+                "    if (( ${#candidates[@]} == 0 )); then\n"
+                "        mapfile -t COMPREPLY < <(compgen -f -- \"${COMP_WORDS[COMP_CWORD]}\")\n"
+                "        return\n"
+                "    fi\n"
+                "    local skip=$(( ${#words[cword]} - ${#COMP_WORDS[COMP_CWORD]} ))\n"
+                "    for candidate in \"${candidates[@]}\"; do\n"
+                "        COMPREPLY+=( \"${candidate:skip}\" )\n"
+                "    done\n"
+                "}\n"
+                "complete -F " + function + " " + name + "\n";
+        case Shell::Zsh:
+            return
+                // A #compdef line can't quote the name, so is left out if it would need it - compdef still registers it
+                ( isPlainShellWord( exeName ) ? "#compdef " + exeName + "\n" : std::string() ) +
+                function + "() {\n"
+                "    local -a candidates described\n"
+                "    local candidate IFS=$'\\n'\n"
+                "    candidates=( $(\"${words[1]}\" " + request + " $(( CURRENT - 1 )) \"${words[@]}\" 2>/dev/null) )\n"
+                "    if (( ${#candidates} == 0 )); then\n"
+                "        _files\n"
+                "        return\n"
+                "    fi\n"
+                "    for candidate in \"${candidates[@]}\"; do\n"
+                "        described+=( \"${${candidate%%$'\\t'*}//:/\\\\:}:${candidate#*$'\\t'}\" )\n"
+                "    done\n"
+                "    _describe 'option' described\n"
+                "}\n"
+                "compdef " + function + " " + name + "\n";
+        case Shell::Fish:
+            return
+                "function " + function + "\n"
+                "    set -l words (commandline -opc)\n"
+                "    $words[1] " + request + " (count $words) $words (commandline -ct) 2>/dev/null\n"
+                "end\n"
+                "complete -c " + name + " -a '(" + function + ")'\n";
+        }
+        return {};
+    }
+
+    CLARA_INLINE auto serialiseSchema( Parser const &parser ) -> std::string {
+        using L = SchemaLayout;
+
+        auto entryCount = parser.m_options.size() + parser.m_args.size();
+        size_t nameCount = 0;
+        for( auto const &opt : parser.m_options )
+            nameCount += opt.optNames().size();
+        auto stringsOffset = 4 * ( L::HeaderFields + entryCount * L::EntryFields + nameCount * ( L::NameFields + L::IndexFields ) );
+
+        std::vector<std::uint32_t> fields = { L::Magic, L::Version, 0, 0, static_cast<std::uint32_t>( entryCount ), static_cast<std::uint32_t>( nameCount ) };
+        std::vector<std::uint32_t> names;
+        std::vector<std::string> nameStrings;
+        std::vector<std::uint32_t> nameEntries;
+        std::string strings;
+        fields.reserve( L::HeaderFields + entryCount * L::EntryFields );
+        names.reserve( nameCount * L::NameFields );
+
+        auto addString = [&]( std::vector<std::uint32_t> &to, std::string const &str ) {
+            to.push_back( static_cast<std::uint32_t>( stringsOffset + strings.size() ) );
+            to.push_back( static_cast<std::uint32_t>( str.size() ) );
+            strings += str;
+        };
+        auto addEntry = [&]( std::uint32_t flags, size_t slot, size_t optNames, std::string const &hint, std::string const &description ) {
+            fields.push_back( flags );
+            fields.push_back( static_cast<std::uint32_t>( slot ) );
+            fields.push_back( static_cast<std::uint32_t>( nameStrings.size() - optNames ) );
+            fields.push_back( static_cast<std::uint32_t>( optNames ) );
+            addString( fields, hint );
+            addString( fields, description );
+        };
+
+        size_t slot = 0;
+        for( auto const &opt : parser.m_options ) {
+            for( auto const &name : opt.optNames() ) {
+                addString( names, name.str() );
+                nameStrings.push_back( normaliseOpt( name.str() ) );
+                nameEntries.push_back( static_cast<std::uint32_t>( slot ) );
+            }
+            auto flags = L::flagsOf( opt );
+            if( opt.isFlag() )
+                flags |= L::IsFlag;
+            addEntry( flags, slot++, opt.optNames().size(), opt.hint(), opt.getHelpColumns().front().right );
+        }
+        for( auto const &arg : parser.m_args ) {
+            addEntry( L::flagsOf( arg ) | L::Positional, slot++, 0, arg.hint(), arg.description() );
+        }
+
+        std::vector<std::uint32_t> index( nameCount );
+        for( size_t i = 0; i < nameCount; ++i )
+            index[i] = static_cast<std::uint32_t>( i );
+        std::sort( index.begin(), index.end(), [&]( std::uint32_t lhs, std::uint32_t rhs ) {
+            return nameStrings[lhs] < nameStrings[rhs];
+        } );
+
+        std::string blob;
+        blob.reserve( stringsOffset + strings.size() );
+        auto write = [&]( std::uint32_t field ) {
+            for( int shift = 0; shift < 32; shift += 8 )
+                blob += static_cast<char>( ( field >> shift ) & 0xff );
+        };
+        for( auto field : fields )
+            write( field );
+        for( auto field : names )
+            write( field );
+        for( auto name : index ) {
+            write( name );
+            write( nameEntries[name] );
+        }
+        blob += strings;
+
+        auto patch = [&]( size_t field, std::uint32_t value ) {
+            for( size_t i = 0; i < 4; ++i )
+                blob[4 * field + i] = static_cast<char>( ( value >> ( 8 * i ) ) & 0xff );
+        };
+        patch( L::SizeField, static_cast<std::uint32_t>( blob.size() ) );
+        patch( L::HashField, hashString( blob.data() + L::HashedFrom, blob.data() + blob.size() ) );
+        return blob;
+    }
+
+    CLARA_INLINE auto SchemaView::isWellFormed( size_t size ) const -> bool {
+        auto tables = 4 * ( L::HeaderFields + std::uint64_t( m_entryCount ) * L::EntryFields + std::uint64_t( m_nameCount ) * ( L::NameFields + L::IndexFields ) );
+        if( tables > size )
+            return false;
+        auto isInBlob = [&]( std::uint32_t offset, std::uint32_t length ) {
+            return offset >= tables && std::uint64_t( offset ) + length <= size;
+        };
+        for( std::uint32_t entry = 0; entry < m_entryCount; ++entry ) {
+            if( std::uint64_t( entryField( entry, L::FirstName ) ) + entryField( entry, L::NameCount ) > m_nameCount ||
+                !isInBlob( entryField( entry, L::HintOffset ), entryField( entry, L::HintSize ) ) ||
+                !isInBlob( entryField( entry, L::DescriptionOffset ), entryField( entry, L::DescriptionSize ) ) )
+                return false;
+        }
+        for( std::uint32_t name = 0; name < m_nameCount; ++name ) {
+            if( !isInBlob( nameField( name, 0 ), nameField( name, 1 ) ) ||
+                indexField( name, 0 ) >= m_nameCount || indexField( name, 1 ) >= m_entryCount )
+                return false;
+        }
+        return true;
+    }
+
+    CLARA_INLINE auto SchemaView::compareName( size_t name, std::string const &optToken ) const -> int {
+        auto size = nameField( name, 1 );
+        auto result = std::memcmp( m_data + nameField( name, 0 ), optToken.data(), (std::min)( size_t( size ), optToken.size() ) );
+        if( result != 0 )
+            return result;
+        return size < optToken.size() ? -1 : size > optToken.size() ? 1 : 0;
+    }
+
+    CLARA_INLINE auto SchemaView::load( void const *data, size_t size ) -> BasicResult<SchemaView> {
+        auto bytes = static_cast<char const *>( data );
+        if( size < 4 * L::HeaderFields || read( bytes, L::MagicField ) != L::Magic )
+            return BasicResult<SchemaView>::runtimeError( "Not a parser schema" );
+        if( read( bytes, L::VersionField ) != L::Version )
+            return BasicResult<SchemaView>::runtimeError( "Unsupported parser schema version: " + std::to_string( read( bytes, L::VersionField ) ) );
+        if( read( bytes, L::SizeField ) != size || read( bytes, L::HashField ) != hashString( bytes + L::HashedFrom, bytes + size ) )
+            return BasicResult<SchemaView>::runtimeError( "Parser schema is corrupt" );
+
+        SchemaView view( bytes, read( bytes, L::EntryCountField ), read( bytes, L::NameCountField ) );
+        if( !view.isWellFormed( size ) )
+            return BasicResult<SchemaView>::runtimeError( "Parser schema is corrupt" );
+        return BasicResult<SchemaView>::ok( view );
+    }
+
+    CLARA_INLINE auto SchemaView::load( void const *data, size_t size, std::uint32_t expectedHash ) -> BasicResult<SchemaView> {
+        auto result = load( data, size );
+        if( result && result.value().hash() != expectedHash )
+            return BasicResult<SchemaView>::runtimeError( "Parser schema is stale" );
+        return result;
+    }
+
+    CLARA_INLINE auto SchemaView::findOpt( std::string const &optToken ) const -> size_t {
+#ifdef CLARA_PLATFORM_WINDOWS
+        if( !optToken.empty() && optToken[0] == '/' )
+            return findOpt( normaliseOpt( optToken ) );
+#endif
+        size_t first = 0, last = m_nameCount;
+        while( first < last ) {
+            auto middle = first + ( last - first ) / 2;
+            auto result = compareName( indexField( middle, 0 ), optToken );
+            if( result == 0 )
+                return indexField( middle, 1 );
+            if( result < 0 )
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        return m_entryCount;
+    }
+
+    CLARA_INLINE auto SchemaView::parse( Args const &args, SchemaBindings &bindings ) const -> InternalParseResult {
+        auto type = ParseResultType::NoMatch;
+        std::uint32_t nextPositional = 0;
+
+        ShortValueOpts shortValueOpts;
+        for( std::uint32_t entry = 0; entry < m_entryCount; ++entry ) {
+            if( entryField( entry, L::Flags ) & ( L::IsFlag | L::Positional ) )
+                continue;
+            auto firstName = entryField( entry, L::FirstName );
+            for( auto name = firstName; name < firstName + entryField( entry, L::NameCount ); ++name ) {
+                if( nameField( name, 1 ) == 2 )
+                    shortValueOpts.add( nameAt( name ) );
+            }
+        }
+        TokenTable table( args, shortValueOpts );
+        TokenStream tokens( table );
+        while( tokens ) {
+            ParserResult result = ParserResult::ok( ParseResultType::Matched );
+            if( tokens->type == TokenType::Option ) {
+                auto entry = findOpt( tokens->token );
+                if( entry == m_entryCount )
+                    return InternalParseResult::runtimeError( "Unrecognised token: " + tokens->token );
+                if( entryField( entry, L::Flags ) & L::IsFlag ) {
+                    result = bindings.setFlag( slotOf( entry ) );
+                }
+                else {
+                    auto remainingTokens = tokens;
+                    ++remainingTokens;
+                    if( !remainingTokens || remainingTokens->type != TokenType::Argument )
+                        return InternalParseResult::runtimeError( "Expected argument following " + tokens->token );
+                    tokens = remainingTokens;
+                    result = bindings.setValue( slotOf( entry ), tokens->token );
+                }
+            }
+            else {
+                while( nextPositional < m_entryCount && !( entryField( nextPositional, L::Flags ) & L::Positional ) )
+                    ++nextPositional;
+                if( nextPositional == m_entryCount )
+                    return InternalParseResult::runtimeError( "Unrecognised token: " + tokens->token );
+                result = bindings.setValue( slotOf( nextPositional ), tokens->token );
+                if( !( entryField( nextPositional, L::Flags ) & L::Unlimited ) )
+                    ++nextPositional;
+            }
+            if( !result )
+                return InternalParseResult( result );
+            if( result.value() == ParseResultType::ShortCircuitAll )
+                return InternalParseResult::ok( ParseState( result.value(), TokenStream() ) );
+            type = ParseResultType::Matched;
+            ++tokens;
+        }
+        return InternalParseResult::ok( ParseState( type, TokenStream() ) );
+    }
+
+    CLARA_INLINE auto SchemaView::getHelpColumns() const -> std::vector<HelpColumns> {
+        std::vector<HelpColumns> cols;
+        for( std::uint32_t entry = 0; entry < m_entryCount; ++entry ) {
+            if( entryField( entry, L::Flags ) & ( L::Positional | L::Hidden ) )
+                continue;
+            std::string left;
+            auto firstName = entryField( entry, L::FirstName );
+            for( auto name = firstName; name < firstName + entryField( entry, L::NameCount ); ++name ) {
+                if( name != firstName )
+                    left += ", ";
+                left += nameAt( name );
+            }
+            auto hint = stringAt( entryField( entry, L::HintOffset ), entryField( entry, L::HintSize ) );
+            if( !hint.empty() )
+                left += " <" + hint + ">";
+            cols.push_back( { left, stringAt( entryField( entry, L::DescriptionOffset ), entryField( entry, L::DescriptionSize ) ) } );
+        }
+        return cols;
+    }
+
+#endif // !CLARA_CONFIG_SEPARATE_COMPILATION || CLARA_IMPLEMENTATION
 } // namespace detail
 
 
 // A Combined parser
 using detail::Parser;
+using detail::ParseSession;
 
 // A parser for options
 using detail::Opt;
+using detail::literal;
 
 // A parser for arguments
 using detail::Arg;
 
 // Wrapper for argc, argv from main()
 using detail::Args;
+using detail::splitCommandLine;
 
 // Specifies the name of the executable
 using detail::ExeName;
@@ -915,11 +4300,50 @@ using detail::Help;
 
 // enum of result types from a parse
 using detail::ParseResultType;
+using detail::Diagnostic;
+using detail::DiagnosticKind;
 
 // Result type for parser operation
 using detail::ParserResult;
 
+// A set of named values to restrict an Opt or Arg to
+using detail::Choices;
+
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+// Instrumentation of Parser::parse
+using detail::ParseObserver;
+using detail::ParseStats;
+using detail::ParseStatsObserver;
+using detail::ConversionKind;
+using detail::ParsePhase;
+#endif
+
+// Compile-time option definitions, and a parser driven directly from them
+using detail::OptSpec;
+using detail::StaticParser;
+using detail::BasicStaticParser;
+using detail::makeStaticParser;
+using detail::areValidOptSpecs;
+using detail::areUniqueOptSpecs;
+
+// Shell completion, answered from an index of a Parser's option names
+using detail::Completion;
+using detail::CompletionResult;
+using detail::CompletionIndex;
+using detail::handleCompletionRequest;
+using detail::Shell;
+using detail::completionScript;
+
+// Serialised parser schemas, for parsing without building the Parser
+using detail::serialiseSchema;
+using detail::SchemaBindings;
+using detail::SchemaView;
+
 
 } // namespace clara
 
+#ifndef CLARA_CONFIG_SEPARATE_COMPILATION
+#   include "clara_containers.hpp"
+#endif
+
 #endif // CLARA_HPP_INCLUDED
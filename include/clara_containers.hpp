@@ -0,0 +1,41 @@
+// Copyright 2017 Two Blue Cubes Ltd. All rights reserved.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+// See https://github.com/philsquared/Clara for more details
+
+// Binding of std::deque, std::set and std::unordered_set (std::vector is in clara.hpp).
+// clara.hpp includes this, unless CLARA_CONFIG_SEPARATE_COMPILATION is defined - then only the
+// code that binds these containers includes it, so that the rest doesn't pay for their headers
+
+#ifndef CLARA_CONTAINERS_HPP_INCLUDED
+#define CLARA_CONTAINERS_HPP_INCLUDED
+
+#include "clara.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <unordered_set>
+
+namespace clara {
+
+    template<typename T, typename AllocatorT>
+    struct ContainerTraits<std::deque<T, AllocatorT>> : detail::SequenceContainerTraits<std::deque<T, AllocatorT>> {};
+
+    template<typename T, typename CompareT, typename AllocatorT>
+    struct ContainerTraits<std::set<T, CompareT, AllocatorT>> : detail::SetContainerTraits<std::set<T, CompareT, AllocatorT>> {};
+
+    template<typename T, typename HashT, typename EqualT, typename AllocatorT>
+    struct ContainerTraits<std::unordered_set<T, HashT, EqualT, AllocatorT>>
+        : detail::SetContainerTraits<std::unordered_set<T, HashT, EqualT, AllocatorT>> {
+        static void reserve( std::unordered_set<T, HashT, EqualT, AllocatorT> &container, size_t additional ) {
+            if( container.bucket_count() * container.max_load_factor() < container.size() + additional )
+                container.reserve( (std::max)( container.size() + additional, container.size() * 2 ) );
+        }
+    };
+
+} // namespace clara
+
+#endif // CLARA_CONTAINERS_HPP_INCLUDED
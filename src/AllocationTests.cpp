@@ -0,0 +1,419 @@
+// Checks how many allocations each parse scenario makes, by counting calls to the global operator new.
+// The budgets are the counts with libstdc++ - lower them when an allocation is removed, so that it
+// cannot creep back in. Other standard libraries allocate differently (their small string buffers
+// differ in size, for a start), so get headroom over them. Paths that do not allocate at all must
+// stay at zero with any standard library.
+
+#include "clara.hpp"
+
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <new>
+
+using namespace clara;
+
+namespace {
+    std::size_t g_allocations = 0;
+
+    class AllocationCounter {
+        std::size_t m_start = g_allocations;
+
+    public:
+        auto count() const -> std::size_t { return g_allocations - m_start; }
+    };
+
+    // The most allocations allowed, for a scenario that makes this many with libstdc++
+    auto budget( std::size_t libstdcxxAllocations ) -> std::size_t {
+#ifdef __GLIBCXX__
+        return libstdcxxAllocations;
+#else
+        return libstdcxxAllocations * 2 + 4;
+#endif
+    }
+}
+
+// Every replaceable form of operator new and delete (other than the over-aligned ones) is replaced,
+// so that all of them count, and each block is freed by the same allocator that made it
+namespace {
+    void* countedAllocate( std::size_t size ) noexcept {
+        ++g_allocations;
+        return std::malloc( size == 0 ? 1 : size );
+    }
+}
+
+void* operator new( std::size_t size ) {
+    if( auto p = countedAllocate( size ) )
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[]( std::size_t size ) {
+    if( auto p = countedAllocate( size ) )
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new( std::size_t size, std::nothrow_t const & ) noexcept {
+    return countedAllocate( size );
+}
+void* operator new[]( std::size_t size, std::nothrow_t const & ) noexcept {
+    return countedAllocate( size );
+}
+void operator delete( void* p ) noexcept {
+    std::free( p );
+}
+void operator delete[]( void* p ) noexcept {
+    std::free( p );
+}
+void operator delete( void* p, std::nothrow_t const & ) noexcept {
+    std::free( p );
+}
+void operator delete[]( void* p, std::nothrow_t const & ) noexcept {
+    std::free( p );
+}
+#ifdef __cpp_sized_deallocation
+void operator delete( void* p, std::size_t ) noexcept {
+    std::free( p );
+}
+void operator delete[]( void* p, std::size_t ) noexcept {
+    std::free( p );
+}
+#endif
+
+TEST_CASE( "allocations: single parsers" ) {
+    std::string name;
+    auto p = Opt( name, "name" )
+        ["-n"]["--name"]
+        ("the name to use");
+
+    auto args = Args{ "TestApp", "--name", "Darth Vader, Lord of the Sith" };
+    AllocationCounter counter;
+    auto result = p.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( allocations <= budget( 1 ) ); // Copying the value, which is too long for the small string buffer
+}
+
+TEST_CASE( "allocations: combined parser" ) {
+    bool showHelp = false;
+    int seed = 0;
+    std::string name;
+    bool flag = false;
+    double value = 0;
+    std::vector<std::string> tests;
+    auto parser
+            = Help( showHelp )
+            | Opt( seed, "time|value" )["--rng-seed"]["-r"]
+            | Opt( name, "name" )["-n"]["--name"]
+            | Opt( flag )["-f"]["--flag"]
+            | Opt( [&]( double d ){ value = d; }, "number" )["-d"]["--double"]
+            | Arg( tests, "test name|tags|pattern" );
+
+    auto args = Args{ "TestApp", "-n", "Bill", "-d:123.45", "-f", "test1", "test2" };
+    AllocationCounter counter;
+    auto result = parser.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( allocations <= budget( 3 ) );
+}
+
+TEST_CASE( "allocations: flags" ) {
+    bool a = false, b = false;
+    auto cli = Opt( a )["-a"] | Opt( b )["--bee"];
+
+    auto args = Args{ "TestApp", "-a", "--bee" };
+    AllocationCounter counter;
+    auto result = cli.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( allocations == 0 ); // Whole args are tokens without being copied
+}
+
+TEST_CASE( "allocations: short bundles" ) {
+    bool a = false, b = false, c = false;
+    auto cli = Opt( a )["-a"] | Opt( b )["-b"] | Opt( c )["-c"];
+
+    auto args = Args{ "TestApp", "-abc" };
+    AllocationCounter counter;
+    auto result = cli.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( allocations == 0 ); // Clusters are decoded in place
+}
+
+TEST_CASE( "allocations: unmatched probes" ) {
+    bool a = false, b = false;
+    int count = 0;
+    std::string name, file;
+    auto cli
+        = Opt( a )["-a"]
+        | Opt( b )["-b"]
+        | Opt( count, "count" )["-c"]
+        | Opt( name, "name" )["-n"]
+        | Arg( file, "file" );
+
+    // Every Opt is tried, and fails to match, before the Arg takes the token
+    auto args = Args{ "TestApp", "file.txt", "-n", "Bill" };
+    AllocationCounter counter;
+    auto result = cli.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( allocations == 0 ); // Parsers pass a cursor into the token table between them
+}
+
+TEST_CASE( "allocations: session steady state" ) {
+    std::string name;
+    int count = 0;
+    bool verbose = false;
+    std::vector<std::string> files;
+    ParseSession session(
+        Opt( name, "name" )["-n"]
+        | Opt( count, "count" )["--count"]
+        | Opt( verbose )["-v"]
+        | Arg( files, "files" ) );
+
+    auto args = Args{ "TestApp", "-n", "Bill", "--count=3", "-v", "a.txt", "b.txt" };
+    REQUIRE( session.parse( args ) );
+    AllocationCounter counter;
+    auto result = session.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( files.size() == 2 );
+    CHECK( allocations == 0 ); // The token table, and the bound strings and containers, are reused
+}
+
+TEST_CASE( "allocations: session steady state with a long exe name" ) {
+    std::string exeName;
+    bool verbose = false;
+    ParseSession session( ExeName( exeName ) | Opt( verbose )["-v"] );
+
+    // Too long for the small string buffer, and with no path to strip
+    auto args = Args{ "a-test-application-with-a-long-name", "-v" };
+    REQUIRE( session.parse( args ) );
+    AllocationCounter counter;
+    auto result = session.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( exeName == "a-test-application-with-a-long-name" );
+    CHECK( allocations == 0 );
+}
+
+TEST_CASE( "allocations: long option names" ) {
+    bool a = false, b = false;
+    auto cli = Opt( a )["--enable-long-feature-a"] | Opt( b )["--enable-long-feature-b"];
+    auto args = Args{ "TestApp", "--enable-long-feature-b", "--enable-long-feature-a" };
+
+    // Names too long for the small string buffer are compared with the tokens in place
+    SECTION( "parsers" ) {
+        AllocationCounter counter;
+        auto result = cli.parse( args );
+        auto allocations = counter.count();
+
+        REQUIRE( result );
+        CHECK( ( a && b ) );
+        CHECK( allocations == 0 );
+    }
+    SECTION( "schemas" ) {
+        struct FlagBindings : SchemaBindings {
+            std::uint32_t set = 0;
+
+            auto setValue( std::uint32_t, std::string const & ) -> ParserResult override {
+                return ParserResult::ok( ParseResultType::Matched );
+            }
+            auto setFlag( std::uint32_t slot ) -> ParserResult override {
+                set |= 1u << slot;
+                return ParserResult::ok( ParseResultType::Matched );
+            }
+        } bindings;
+        auto blob = serialiseSchema( cli );
+        auto view = SchemaView::load( blob.data(), blob.size() );
+        REQUIRE( view );
+
+        AllocationCounter counter;
+        auto result = view.value().parse( args, bindings );
+        auto allocations = counter.count();
+
+        REQUIRE( result );
+        CHECK( bindings.set == 3 );
+        CHECK( allocations == 0 );
+    }
+}
+
+TEST_CASE( "allocations: repeated delimited options" ) {
+    std::vector<int> ids;
+    auto cli = Parser() | Opt( ids, "ids" )["--ids"].delimiter( ',' );
+
+    std::vector<std::string> argStrings{ "TestApp" };
+    for( int i = 0; i < 1000; ++i )
+        argStrings.push_back( "--ids=" + std::to_string( i ) );
+    std::vector<char const *> argv;
+    for( auto const &arg : argStrings )
+        argv.push_back( arg.c_str() );
+    Args args( static_cast<int>( argv.size() ), argv.data() );
+
+    AllocationCounter counter;
+    auto result = cli.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( ids.size() == 1000 );
+    CHECK( allocations <= budget( 13 ) ); // The vector grows geometrically, rather than by one for each option
+}
+
+#if defined(CLARA_CONFIG_OPTIONAL_TYPE)
+TEST_CASE( "allocations: optional" ) {
+    CLARA_CONFIG_OPTIONAL_TYPE<std::string> name;
+    auto p = Opt( name, "name" )["-n"];
+
+    auto args = Args{ "TestApp", "-n", "Pixie" };
+    AllocationCounter counter;
+    auto result = p.parse( args );
+    auto allocations = counter.count();
+
+    REQUIRE( result );
+    CHECK( allocations == 0 );
+}
+#endif // CLARA_CONFIG_OPTIONAL_TYPE
+
+TEST_CASE( "allocations: help" ) {
+    int i = 0;
+    std::string s;
+    auto cli
+        = Opt( i, "i" )["-i"]["--int"]( "An integer, with a description long enough to need wrapping onto a second line" )
+        | Opt( s, "s" )["-s"]( "A string" );
+
+    std::ostringstream oss;
+    AllocationCounter counter;
+    oss << cli;
+    auto allocations = counter.count();
+
+    REQUIRE( !oss.str().empty() );
+    CHECK( allocations <= budget( 54 ) );
+}
+
+TEST_CASE( "allocations: literal text" ) {
+    std::string name;
+    auto build = [&]( Opt const &opt ) -> std::size_t {
+        AllocationCounter counter;
+        auto cli = Parser() | opt;
+        return counter.count();
+    };
+
+    // Text too long for the small string buffer: referred to with literal(), and copied from std::strings and plain literals
+    AllocationCounter literalCounter;
+    auto literalText = Opt( name, literal( "a hint that is long enough" ) )
+        [literal( "--a-name-that-is-long-enough" )]( literal( "a description that is long enough" ) );
+    auto literalAllocations = literalCounter.count();
+
+    std::string hint = "a hint that is long enough", optName = "--a-name-that-is-long-enough", description = "a description that is long enough";
+    AllocationCounter ownedCounter;
+    auto owned = Opt( name, hint )[optName]( description );
+    auto ownedAllocations = ownedCounter.count();
+
+    AllocationCounter copiedCounter;
+    auto copied = Opt( name, "a hint that is long enough" )["--a-name-that-is-long-enough"]( "a description that is long enough" );
+    auto copiedAllocations = copiedCounter.count();
+
+    AllocationCounter shortCounter;
+    auto shortText = Opt( name, "h" )["-n"]( "d" );
+    auto shortAllocations = shortCounter.count();
+
+    CHECK( literalAllocations == shortAllocations ); // Only the bound reference and the names vector
+    CHECK( ownedAllocations > shortAllocations );
+    CHECK( copiedAllocations > shortAllocations ); // Plain string literals are copied, like any other text
+    CHECK( build( literalText ) == build( shortText ) ); // Copying the Opt into the Parser doesn't copy the text either
+    CHECK( build( owned ) > build( shortText ) );
+    (void)copied;
+
+#ifdef CLARA_CONFIG_STRING_VIEW
+    // As are std::string_views, which do not own their text either
+    AllocationCounter viewCounter;
+    auto viewText = Opt( name, std::string_view( "a hint that is long enough" ) )
+        [std::string_view( "--a-name-that-is-long-enough" )]( std::string_view( "a description that is long enough" ) );
+    auto viewAllocations = viewCounter.count();
+
+    CHECK( viewAllocations == shortAllocations );
+    CHECK( build( viewText ) == build( shortText ) );
+#endif
+
+    // Help's own text is all literal, so costs no more to copy than a flag with one letter text
+    bool showHelp = false, flag = false;
+    std::string searchTerm;
+    auto shortFlag = Opt( flag )["-?"]["-h"]["-x"]( "d" );
+    CHECK( build( Help( showHelp ) ) == build( shortFlag ) );
+    CHECK( build( Help( showHelp, searchTerm ) ) == build( shortFlag ) );
+}
+
+TEST_CASE( "allocations: lambdas" ) {
+    int total = 0;
+    std::string suffix = "!";
+
+    AllocationCounter referenceCounter;
+    auto byReference = Opt( [&]( std::string const &s ) { total += static_cast<int>( s.size() ); }, "s" )["-s"];
+    auto referenceAllocations = referenceCounter.count();
+
+    // Lambdas that capture a std::string by value are held in place too
+    AllocationCounter valueCounter;
+    auto byValue = Opt( [suffix, &total]( std::string const &s ) { total += static_cast<int>( ( s + suffix ).size() ); }, "s" )["-s"];
+    auto valueAllocations = valueCounter.count();
+
+    CHECK( valueAllocations == referenceAllocations );
+    REQUIRE( byValue.parse( Args{ "TestApp", "-s", "abc" } ) );
+    CHECK( total == 4 );
+    (void)byReference;
+}
+
+constexpr OptSpec staticSpecs[] = {
+    { "-n", "--name", "name", "the name to use" },
+    { "-f", nullptr, nullptr, "a flag" }
+};
+
+TEST_CASE( "allocations: zero allocation paths" ) {
+
+    SECTION( "constructing a static parser" ) {
+        std::string name;
+        bool flag = false;
+
+        AllocationCounter counter;
+        auto cli = makeStaticParser( staticSpecs, name, flag );
+        CHECK( counter.count() == 0 );
+        (void)cli;
+    }
+    SECTION( "constructing a compiled static parser" ) {
+        std::string name;
+        bool flag = false;
+
+        AllocationCounter counter;
+        auto cli = makeStaticParser<2, staticSpecs>( name, flag );
+        CHECK( counter.count() == 0 );
+        (void)cli;
+    }
+    SECTION( "looking up a choice" ) {
+        auto choices = Choices<int>{ { "one", 1 }, { "two", 2 }, { "three", 3 } };
+        std::string name = "two";
+
+        AllocationCounter counter;
+        auto value = choices.find( name );
+        CHECK( counter.count() == 0 );
+        REQUIRE( value );
+        CHECK( *value == 2 );
+    }
+    SECTION( "loading a schema" ) {
+        std::string name;
+        bool flag = false;
+        auto blob = serialiseSchema( Opt( name, "name" )["-n"]["--name"] | Opt( flag )["-f"] );
+        std::string optName = "--name";
+
+        AllocationCounter counter;
+        auto view = SchemaView::load( blob.data(), blob.size() );
+        auto entry = view.value().findOpt( optName );
+        CHECK( counter.count() == 0 );
+        CHECK( entry == 0 );
+    }
+}
@@ -0,0 +1,183 @@
+// Fuzzing driver for TokenStream and Parser::parse.
+//
+// Each input is split on newlines into the args of a command line.
+// Built with CLARA_FUZZ_WITH_LIBFUZZER (see CMakeLists.txt) this is a libFuzzer target.
+// Otherwise it is a plain driver that replays the input files given on the command line
+// or, with --scaling, checks that parse time grows linearly on adversarial inputs.
+
+#include "clara.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+using namespace clara;
+
+namespace {
+
+    auto splitArgs( std::string const &input ) -> std::vector<std::string> {
+        std::vector<std::string> args{ "fuzz" };
+        std::istringstream iss( input );
+        std::string arg;
+        while( std::getline( iss, arg ) )
+            args.push_back( arg );
+        return args;
+    }
+
+    auto makeArgs( std::vector<std::string> const &args ) -> Args {
+        std::vector<char const *> argv;
+        for( auto const &arg : args )
+            argv.push_back( arg.c_str() );
+        return Args( static_cast<int>( argv.size() ), argv.data() );
+    }
+
+    constexpr OptSpec fuzzSpecs[] = {
+        { "-n", "--name", "name", "a name" },
+        { "-f", "--flag", nullptr, "a flag" },
+        { nullptr, nullptr, "files", "some files" }
+    };
+
+    // Returns the total size of the tokens seen, so the walk can't be optimised away
+    auto fuzzOne( std::string const &input ) -> size_t {
+        auto args = makeArgs( splitArgs( input ) );
+
+        // Walk the raw token stream
+        size_t tokens = 0;
+        detail::TokenTable table( args, detail::ShortValueOpts() );
+        for( detail::TokenStream stream( table ); stream; ++stream )
+            tokens += stream->token.size() + 1;
+
+        bool showHelp = false, a = false, b = false;
+        std::string name;
+        int number = 0;
+        std::vector<int> ids;
+        std::set<std::string> tags;
+        std::vector<std::string> files;
+        auto parser
+            = ExeName()
+            | Help( showHelp )
+            | Opt( a )["-a"]["--aa"]
+            | Opt( b )["-b"]
+            | Opt( name, "name" )["-n"]["--name"]
+            | Opt( number, "number" )["-i"]["--int"]
+            | Opt( ids, "ids" )["--ids"].delimiter( ',' )
+            | Opt( tags, Choices<std::string>{ "red", "green", "blue" }, "tag" )["-t"]
+            | Opt( [&]( double ) {}, "double" )["-d"]
+            | Arg( files, "files" );
+        auto result = parser.parse( args );
+        if( result && showHelp ) {
+            std::ostringstream oss;
+            oss << parser;
+        }
+
+        std::string staticName;
+        bool staticFlag = false;
+        std::vector<std::string> staticFiles;
+        makeStaticParser( fuzzSpecs, staticName, staticFlag, staticFiles ).parse( args );
+        return tokens;
+    }
+
+}
+
+#ifdef CLARA_FUZZ_WITH_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput( std::uint8_t const *data, std::size_t size ) {
+    fuzzOne( std::string( reinterpret_cast<char const *>( data ), size ) );
+    return 0;
+}
+
+#else // CLARA_FUZZ_WITH_LIBFUZZER
+
+namespace {
+
+    // Adversarial inputs, generated at a given size
+    struct ScalingCase {
+        char const *name;
+        auto ( *generate )( size_t size ) -> std::string;
+    };
+
+    auto shortBundle( size_t size ) -> std::string {
+        return "-" + std::string( size, 'a' );
+    }
+    auto equalsSplits( size_t size ) -> std::string {
+        std::string input;
+        for( size_t i = 0; i < size; ++i )
+            input += "--ids=" + std::to_string( i ) + "\n";
+        return input;
+    }
+    auto longOptionName( size_t size ) -> std::string {
+        return "--" + std::string( size * 8, 'x' ) + "\n--" + std::string( size * 8, 'y' ) + "=1";
+    }
+    auto manyPositionals( size_t size ) -> std::string {
+        std::string input;
+        for( size_t i = 0; i < size; ++i )
+            input += "file" + std::to_string( i ) + "\n";
+        return input;
+    }
+    auto longDelimitedList( size_t size ) -> std::string {
+        std::string input = "--ids=0";
+        for( size_t i = 1; i < size * 4; ++i )
+            input += "," + std::to_string( i );
+        return input;
+    }
+
+    auto timeOne( std::string const &input ) -> double {
+        double best = 0;
+        for( int run = 0; run < 5; ++run ) {
+            auto start = std::chrono::steady_clock::now();
+            fuzzOne( input );
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if( run == 0 || elapsed.count() < best )
+                best = elapsed.count();
+        }
+        return best;
+    }
+
+    // Parsing 8x the input should take about 8x as long. Quadratic behaviour would make it 64x,
+    // so anything over 20x is taken as a failure (allowing for timing noise)
+    auto checkScaling() -> int {
+        ScalingCase const cases[] = {
+            { "short bundle", &shortBundle },
+            { "'=' splits", &equalsSplits },
+            { "long option names", &longOptionName },
+            { "many positionals", &manyPositionals },
+            { "long delimited list", &longDelimitedList }
+        };
+        size_t const smallSize = 10000;
+        double const maxRatio = 20;
+
+        int failures = 0;
+        for( auto const &scalingCase : cases ) {
+            auto small = timeOne( scalingCase.generate( smallSize ) );
+            auto large = timeOne( scalingCase.generate( smallSize * 8 ) );
+            auto ratio = large / ( small > 0 ? small : 1e-9 );
+            auto ok = ratio <= maxRatio;
+            std::cout << ( ok ? "ok    " : "FAILED" ) << " " << scalingCase.name << ": 8x input took " << ratio << "x as long\n";
+            if( !ok )
+                ++failures;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+}
+
+int main( int argc, char **argv ) {
+    if( argc == 2 && std::string( argv[1] ) == "--scaling" )
+        return checkScaling();
+
+    for( int i = 1; i < argc; ++i ) {
+        std::ifstream file( argv[i], std::ios::binary );
+        if( !file ) {
+            std::cerr << "Unable to open " << argv[i] << std::endl;
+            return 1;
+        }
+        fuzzOne( std::string( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() ) );
+    }
+    std::cout << "Replayed " << ( argc - 1 ) << " inputs" << std::endl;
+    return 0;
+}
+
+#endif // CLARA_FUZZ_WITH_LIBFUZZER
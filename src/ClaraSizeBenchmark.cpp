@@ -0,0 +1,109 @@
+// Code size benchmark: a Parser with 200 options of mixed types - scalars of a dozen types,
+// containers and Choices, with a distinct lambda for each of 40 of them, as a large program might have.
+// The RunSizeCheck test checks the size of its text section against the budget in CMake/ClaraSizeBudget.cmake.
+// Run, it parses a command line that sets one option of each kind.
+
+#include "clara.hpp"
+
+#include <iostream>
+
+using namespace clara;
+
+namespace {
+
+    enum class Colour { Red, Green, Blue };
+
+    struct Values {
+        bool flags[16] = {};
+        int ints[12] = {};
+        unsigned unsigneds[8] = {};
+        short shorts[6] = {};
+        long longs[8] = {};
+        long long longLongs[6] = {};
+        unsigned long unsignedLongs[6] = {};
+        std::size_t sizes[6] = {};
+        float floats[8] = {};
+        double doubles[12] = {};
+        char chars[6] = {};
+        std::string strings[32] = {};
+        std::vector<int> intLists[8];
+        std::vector<std::string> stringLists[8];
+        std::set<std::string> stringSets[6];
+        std::deque<double> doubleLists[6];
+        Colour colours[6] = {};
+        int lambdaTotal = 0;
+    };
+
+    template<typename T, std::size_t N>
+    void addOpts( Parser &cli, T ( &values )[N], std::string const &name, char delimiter = '\0' ) {
+        for( std::size_t i = 0; i < N; ++i ) {
+            auto opt = Opt( values[i], name )["--" + name + std::to_string( i )]( "a " + name );
+            if( delimiter != '\0' )
+                opt.delimiter( delimiter );
+            cli |= opt;
+        }
+    }
+
+    // Each N makes a distinct lambda type, as each lambda written out in a program does
+    template<int N>
+    struct LambdaOpts {
+        static void add( Parser &cli, int &total ) {
+            LambdaOpts<N - 1>::add( cli, total );
+            cli |= Opt( [&total]( int value ) { total += N * value; }, "n" )["--lambda" + std::to_string( N )]( "a callback" );
+        }
+    };
+    template<>
+    struct LambdaOpts<0> {
+        static void add( Parser &, int & ) {}
+    };
+
+    auto makeParser( Values &values ) -> Parser {
+        Parser cli;
+        for( std::size_t i = 0; i < 16; ++i )
+            cli |= Opt( values.flags[i] )["--flag" + std::to_string( i )]( "a flag" );
+        addOpts( cli, values.ints, "int" );
+        addOpts( cli, values.unsigneds, "unsigned" );
+        addOpts( cli, values.shorts, "short" );
+        addOpts( cli, values.longs, "long" );
+        addOpts( cli, values.longLongs, "long-long" );
+        addOpts( cli, values.unsignedLongs, "unsigned-long" );
+        addOpts( cli, values.sizes, "size" );
+        addOpts( cli, values.floats, "float" );
+        addOpts( cli, values.doubles, "double" );
+        addOpts( cli, values.chars, "char" );
+        addOpts( cli, values.strings, "string" );
+        addOpts( cli, values.intLists, "ints", ',' );
+        addOpts( cli, values.stringLists, "strings" );
+        addOpts( cli, values.stringSets, "string-set" );
+        addOpts( cli, values.doubleLists, "doubles", ',' );
+        auto colours = Choices<Colour>{ { "red", Colour::Red }, { "green", Colour::Green }, { "blue", Colour::Blue } };
+        for( std::size_t i = 0; i < 6; ++i )
+            cli |= Opt( values.colours[i], colours, "colour" )["--colour" + std::to_string( i )]( "a colour" );
+        LambdaOpts<40>::add( cli, values.lambdaTotal );
+        return cli;
+    }
+}
+
+int main() {
+    Values values;
+    auto cli = makeParser( values );
+    auto count = cli.m_options.size();
+
+    auto result = cli.parse( Args{ "ClaraSizeBenchmark",
+        "--flag3", "--int2=-7", "--unsigned1", "8", "--short0", "9", "--long4", "10", "--long-long1", "11",
+        "--unsigned-long2", "12", "--size3", "13", "--float1", "1.5", "--double7", "2.5", "--char0", "c",
+        "--string9", "text", "--ints2=1,2,3", "--strings1", "a", "--string-set5", "b", "--doubles0=0.5,1.5",
+        "--colour2", "blue", "--lambda3", "2", "--lambda40", "1" } );
+    if( !result ) {
+        std::cerr << result.errorMessage() << std::endl;
+        return 1;
+    }
+    bool ok = count == 200 && values.flags[3] && values.ints[2] == -7 && values.unsigneds[1] == 8u &&
+        values.shorts[0] == 9 && values.longs[4] == 10 && values.longLongs[1] == 11 && values.unsignedLongs[2] == 12u &&
+        values.sizes[3] == 13u && values.floats[1] == 1.5f && values.doubles[7] == 2.5 && values.chars[0] == 'c' &&
+        values.strings[9] == "text" && values.intLists[2].size() == 3 && values.stringLists[1].size() == 1 &&
+        values.stringSets[5].count( "b" ) == 1 && values.doubleLists[0].size() == 2 &&
+        values.colours[2] == Colour::Blue && values.lambdaTotal == 3 * 2 + 40;
+    std::cout << ( ok ? "Parsed " : "FAILED to parse " ) << count << " options" << std::endl;
+    return ok ? 0 : 1;
+}
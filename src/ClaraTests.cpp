@@ -1,8 +1,26 @@
+// Built on their own, the tests cover every optional feature. Linked to the clara library (as
+// ClaraSeparateTests) they cover the features that it was built with
+#ifndef CLARA_CONFIG_SEPARATE_COMPILATION
+#define CLARA_CONFIG_PARSE_OBSERVER
+#define CLARA_CONFIG_PARALLEL_CONVERSION
+#define CLARA_CONFIG_PARALLEL_VALIDATION
+#endif
 #include "clara.hpp"
+#include "clara_textflow.hpp" // These two are not included by clara.hpp with CLARA_CONFIG_SEPARATE_COMPILATION
+#include "clara_containers.hpp"
 
 #include "catch.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <chrono>
+#include <limits>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
 
 using namespace clara;
 
@@ -560,3 +578,1545 @@ TEST_CASE("Reading into std::optional") {
     }
 }
 #endif // CLARA_CONFIG_OPTIONAL_TYPE
+
+constexpr OptSpec staticSpecs[] = {
+    { "-n", "--name", "name", "the name to use" },
+    { "-f", "--flag", nullptr, "a flag to set" },
+    { "-d", "--double", "number", "just some number" },
+    { nullptr, nullptr, "test name|tags|pattern", "which test or tests to use" }
+};
+static_assert( areValidOptSpecs( staticSpecs ), "static specs should be valid" );
+static_assert( areUniqueOptSpecs( staticSpecs ), "static specs should be unique" );
+
+constexpr OptSpec duplicateSpecs[] = {
+    { "-a", "--all", nullptr, "" },
+    { "-b", "--all", nullptr, "" }
+};
+static_assert( !areUniqueOptSpecs( duplicateSpecs ), "duplicate names should be detected" );
+
+constexpr OptSpec invalidSpecs[] = {
+    { "-a", "all", nullptr, "" },
+    { "-b=", nullptr, nullptr, "" }
+};
+static_assert( !areValidOptSpecs( invalidSpecs ), "invalid names should be detected" );
+
+// With the specs as a template argument, flags bound to anything but bools don't compile
+using CompiledStaticLookup = detail::CompiledOptLookup<4, staticSpecs>;
+static_assert( CompiledStaticLookup::canBind<1, bool>(), "flags can be bound to bools" );
+static_assert( !CompiledStaticLookup::canBind<1, int>(), "flags cannot be bound to anything else" );
+static_assert( CompiledStaticLookup::canBind<0, int>(), "options with values can be bound to anything" );
+
+// Enough names for several passes of the compile-time sort, with some specs missing long names
+constexpr OptSpec manySpecs[] = {
+    { "-a", nullptr, "value", "" },
+    { "-b", "--opt-1", "value", "" },
+    { "-c", "--opt-2", "value", "" },
+    { "-d", nullptr, "value", "" },
+    { "-e", "--opt-4", "value", "" },
+    { "-f", "--opt-5", "value", "" },
+    { "-g", nullptr, "value", "" },
+    { "-h", "--opt-7", "value", "" },
+    { "-i", "--opt-8", "value", "" },
+    { "-j", nullptr, "value", "" },
+    { "-k", "--opt-10", "value", "" },
+    { "-l", "--opt-11", "value", "" },
+    { "-m", nullptr, "value", "" },
+    { "-n", "--opt-13", "value", "" },
+    { "-o", "--opt-14", "value", "" },
+    { "-p", nullptr, "value", "" },
+    { "-q", "--opt-16", "value", "" },
+    { "-r", "--opt-17", "value", "" },
+    { "-s", nullptr, "value", "" },
+    { "-t", "--opt-19", "value", "" }
+};
+
+TEST_CASE( "static parser" ) {
+    using namespace Catch::Matchers;
+
+    std::string name;
+    bool flag = false;
+    double value = 0;
+    std::vector<std::string> tests;
+    auto cli = makeStaticParser( staticSpecs, name, flag, value, tests );
+
+    SECTION( "options and args" ) {
+        auto result = cli.parse( Args{ "TestApp", "-n", "Bill", "--double:123.45", "-f", "test1", "test2" } );
+        CHECK( result );
+        CHECK( result.value().type() == ParseResultType::Matched );
+
+        REQUIRE( name == "Bill" );
+        REQUIRE( flag );
+        REQUIRE( value == 123.45 );
+        REQUIRE( tests == std::vector<std::string>{ "test1", "test2" } );
+    }
+    SECTION( "no args" ) {
+        auto result = cli.parse( Args{ "TestApp" } );
+        CHECK( result );
+        CHECK( result.value().type() == ParseResultType::NoMatch );
+        REQUIRE( name == "" );
+    }
+    SECTION( "missing argument" ) {
+        auto result = cli.parse( Args{ "TestApp", "--name" } );
+        CHECK( !result );
+        CHECK( result.errorMessage() == "Expected argument following --name" );
+    }
+    SECTION( "conversion failure" ) {
+        auto result = cli.parse( Args{ "TestApp", "-d", "lots" } );
+        CHECK( !result );
+        CHECK( result.errorMessage() == "Unable to convert 'lots' to destination type" );
+    }
+    SECTION( "unrecognised option" ) {
+        auto result = cli.parse( Args{ "TestApp", "--nam", "Bill" } );
+        CHECK( !result );
+        CHECK_THAT( result.errorMessage(), Contains( "Unrecognised token" ) && Contains( "--nam" ) );
+    }
+    SECTION( "usage matches the equivalent parser" ) {
+        auto parser
+                = Opt( name, "name" )
+                    ["-n"]["--name"]
+                    ( "the name to use" )
+                | Opt( flag )
+                    ["-f"]["--flag"]
+                    ( "a flag to set" )
+                | Opt( value, "number" )
+                    ["-d"]["--double"]
+                    ( "just some number" )
+                | Arg( tests, "test name|tags|pattern" )
+                    ( "which test or tests to use" );
+
+        std::ostringstream oss;
+        oss << cli;
+        REQUIRE( oss.str() == toString( parser ) );
+    }
+}
+
+struct PathList {
+    std::vector<std::string> paths;
+};
+
+namespace clara {
+    template<>
+    struct ContainerTraits<PathList> {
+        static const bool isContainer = true;
+        using ValueType = std::string;
+
+        static void add( PathList &list, std::string &&path ) { list.paths.push_back( std::move( path ) ); }
+        static void reserve( PathList &list, size_t additional ) { list.paths.reserve( list.paths.size() + additional ); }
+    };
+}
+
+TEST_CASE( "compiled static parser" ) {
+    std::string name;
+    bool flag = false;
+    double value = 0;
+    std::vector<std::string> tests;
+    auto cli = makeStaticParser<4, staticSpecs>( name, flag, value, tests );
+
+    SECTION( "options and args" ) {
+        auto result = cli.parse( Args{ "TestApp", "--name", "Bill", "-d", "1.5", "--flag", "test1", "test2" } );
+        REQUIRE( result );
+        CHECK( name == "Bill" );
+        CHECK( flag );
+        CHECK( value == 1.5 );
+        CHECK( tests == std::vector<std::string>{ "test1", "test2" } );
+    }
+    SECTION( "unrecognised option" ) {
+        auto result = cli.parse( Args{ "TestApp", "--nam", "Bill" } );
+        REQUIRE( !result );
+        CHECK( result.errorMessage() == "Unrecognised token: --nam" );
+    }
+    SECTION( "usage matches the runtime static parser" ) {
+        std::ostringstream compiled, runtime;
+        compiled << cli;
+        runtime << makeStaticParser( staticSpecs, name, flag, value, tests );
+        CHECK( compiled.str() == runtime.str() );
+    }
+    SECTION( "every name is found" ) {
+        std::vector<int> values( 20 );
+        auto many = makeStaticParser<20, manySpecs>(
+            values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7], values[8], values[9],
+            values[10], values[11], values[12], values[13], values[14], values[15], values[16], values[17], values[18], values[19] );
+        for( int k = 0; k < 20; ++k ) {
+            std::string shortName = { '-', static_cast<char>( 'a' + k ) };
+            REQUIRE( many.parse( Args{ "TestApp", shortName, std::to_string( k ) } ) );
+            if( k % 3 != 0 )
+                REQUIRE( many.parse( Args{ "TestApp", "--opt-" + std::to_string( k ), std::to_string( k + 1 ) } ) );
+        }
+        for( int k = 0; k < 20; ++k )
+            CHECK( values[static_cast<size_t>( k )] == ( k % 3 != 0 ? k + 1 : k ) );
+        CHECK( !many.parse( Args{ "TestApp", "--opt-0" } ) );
+        CHECK( !many.parse( Args{ "TestApp", "-z" } ) );
+    }
+#if __cplusplus >= 201703L
+    SECTION( "the size of the specs is deduced from C++17" ) {
+        auto deduced = makeStaticParser<staticSpecs>( name, flag, value, tests );
+        REQUIRE( deduced.parse( Args{ "TestApp", "-n", "Ben" } ) );
+        CHECK( name == "Ben" );
+    }
+#endif
+}
+
+TEST_CASE( "container bindings" ) {
+
+    SECTION( "vector" ) {
+        std::vector<int> values;
+        auto result = ( Parser() | Arg( values, "value" ) ).parse( { "TestApp", "3", "1", "3" } );
+        REQUIRE( result );
+        REQUIRE( values == std::vector<int>{ 3, 1, 3 } );
+        REQUIRE( values.capacity() >= 3 );
+    }
+    SECTION( "deque" ) {
+        std::deque<std::string> values;
+        auto result = ( Parser() | Arg( values, "value" ) ).parse( { "TestApp", "b", "a", "b" } );
+        REQUIRE( result );
+        REQUIRE( values == std::deque<std::string>{ "b", "a", "b" } );
+    }
+    SECTION( "set" ) {
+        std::set<std::string> values;
+        auto result = ( Parser() | Arg( values, "value" ) ).parse( { "TestApp", "b", "a", "b" } );
+        REQUIRE( result );
+        REQUIRE( values == std::set<std::string>{ "a", "b" } );
+    }
+    SECTION( "unordered_set" ) {
+        std::unordered_set<int> values;
+        auto result = ( Parser() | Arg( values, "value" ) ).parse( { "TestApp", "2", "1", "2" } );
+        REQUIRE( result );
+        REQUIRE( values == std::unordered_set<int>{ 1, 2 } );
+    }
+    SECTION( "repeated option into a set" ) {
+        std::set<int> values;
+        auto result = ( Parser() | Opt( values, "value" )["-v"] ).parse( { "TestApp", "-v", "2", "-v", "1", "-v", "2" } );
+        REQUIRE( result );
+        REQUIRE( values == std::set<int>{ 1, 2 } );
+    }
+    SECTION( "conversion failure leaves earlier values" ) {
+        std::set<int> values;
+        auto result = ( Parser() | Arg( values, "value" ) ).parse( { "TestApp", "1", "two" } );
+        REQUIRE( !result );
+        REQUIRE( values == std::set<int>{ 1 } );
+    }
+    SECTION( "user container" ) {
+        PathList list;
+        auto parser = Parser() | Arg( list, "path" );
+        auto result = parser.parse( { "TestApp", "a", "b" } );
+        REQUIRE( result );
+        REQUIRE( list.paths == std::vector<std::string>{ "a", "b" } );
+        REQUIRE_THAT( toString( parser ), Catch::Matchers::Contains( "<path> ..." ) );
+    }
+}
+
+TEST_CASE( "end of options marker" ) {
+
+    bool flag = false;
+    std::string first;
+    std::vector<std::string> rest;
+    auto cli = Opt( flag )["-f"]
+             | Arg( first, "first" )
+             | Arg( rest, "rest" );
+
+    SECTION( "options before the marker are still parsed" ) {
+        auto result = cli.parse( { "TestApp", "-f", "--", "a" } );
+        REQUIRE( result );
+        REQUIRE( flag );
+        REQUIRE( first == "a" );
+        REQUIRE( rest.empty() );
+    }
+    SECTION( "anything after the marker is an argument" ) {
+        auto result = cli.parse( { "TestApp", "--", "-f", "--name=x", "--", "-" } );
+        REQUIRE( result );
+        REQUIRE( flag == false );
+        REQUIRE( first == "-f" );
+        REQUIRE( rest == std::vector<std::string>{ "--name=x", "--", "-" } );
+    }
+    SECTION( "marker on its own" ) {
+        auto result = cli.parse( { "TestApp", "--" } );
+        REQUIRE( result );
+        REQUIRE( first == "" );
+    }
+    SECTION( "conversion failure in bulk" ) {
+        std::vector<int> numbers;
+        auto result = ( Parser() | Arg( numbers, "number" ) ).parse( { "TestApp", "--", "1", "-2", "three", "4" } );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Unable to convert 'three' to destination type" );
+        REQUIRE( numbers == std::vector<int>{ 1, -2 } );
+    }
+    SECTION( "unmatched argument after marker" ) {
+        auto result = ( Parser() | Opt( flag )["-f"] ).parse( { "TestApp", "--", "-f" } );
+        REQUIRE( !result );
+        REQUIRE_THAT( result.errorMessage(), Catch::Matchers::Contains( "Unrecognised token: -f" ) );
+    }
+}
+
+TEST_CASE( "delimited lists" ) {
+    using namespace Catch::Matchers;
+
+    std::vector<int> ids;
+    std::set<std::string> names;
+    auto cli = Opt( ids, "id,..." )
+                ["--ids"]
+                .delimiter( ',' )
+             | Opt( names, "name:..." )
+                ["-n"]
+                .delimiter( ':' );
+
+    SECTION( "integers" ) {
+        auto result = cli.parse( { "TestApp", "--ids=1,-2,+3,2147483647,-2147483648" } );
+        REQUIRE( result );
+        REQUIRE( ids == std::vector<int>{ 1, -2, 3, 2147483647, -2147483647 - 1 } );
+    }
+    SECTION( "strings into a set" ) {
+        auto result = cli.parse( { "TestApp", "-n", "b:a:b:" } );
+        REQUIRE( result );
+        REQUIRE( names == std::set<std::string>{ "", "a", "b" } );
+    }
+    SECTION( "repeated options append" ) {
+        auto result = cli.parse( { "TestApp", "--ids", "1,2", "--ids", "3" } );
+        REQUIRE( result );
+        REQUIRE( ids == std::vector<int>{ 1, 2, 3 } );
+    }
+    SECTION( "empty list" ) {
+        auto result = cli.parse( { "TestApp", "--ids=" } );
+        REQUIRE( result );
+        REQUIRE( ids.empty() );
+    }
+    SECTION( "error reports the element index" ) {
+        auto result = cli.parse( { "TestApp", "--ids=1,2,x3,4" } );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Unable to convert 'x3' to destination type (at list index 2)" );
+        REQUIRE( ids == std::vector<int>{ 1, 2 } );
+    }
+    SECTION( "overflow" ) {
+        auto result = cli.parse( { "TestApp", "--ids=2147483648" } );
+        REQUIRE( !result );
+        REQUIRE_THAT( result.errorMessage(), Contains( "'2147483648'" ) );
+    }
+    SECTION( "negative unsigned" ) {
+        std::vector<unsigned> values;
+        auto result = ( Parser() | Opt( values, "values" )["-v"].delimiter( ',' ) ).parse( { "TestApp", "-v", "1,-1" } );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Unable to convert '-1' to destination type (at list index 1)" );
+    }
+    SECTION( "non-integral elements" ) {
+        std::vector<double> values;
+        auto result = ( Parser() | Opt( values, "values" )["-v"].delimiter( ',' ) ).parse( { "TestApp", "-v", "1.5,2" } );
+        REQUIRE( result );
+        REQUIRE( values == std::vector<double>{ 1.5, 2 } );
+    }
+    SECTION( "lambda is called per element" ) {
+        std::vector<int> seen;
+        auto lambdaCli = Parser() | Opt( [&]( int i ) { seen.push_back( i * 10 ); }, "values" )["-v"].delimiter( ',' );
+        auto result = lambdaCli.parse( { "TestApp", "-v", "1,2" } );
+        REQUIRE( result );
+        REQUIRE( seen == std::vector<int>{ 10, 20 } );
+    }
+    SECTION( "flags cannot be delimited" ) {
+        bool flag = false;
+        auto result = ( Parser() | Opt( flag )["-f"].delimiter( ',' ) ).parse( { "TestApp", "-f" } );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Flags cannot take a delimited list" );
+    }
+}
+
+enum class Verbosity { Quiet, Normal, High };
+
+TEST_CASE( "choices" ) {
+    using namespace Catch::Matchers;
+
+    auto verbosities = Choices<Verbosity>{
+        { "quiet", Verbosity::Quiet },
+        { "normal", Verbosity::Normal },
+        { "high", Verbosity::High }
+    };
+    auto verbosity = Verbosity::Normal;
+    std::string region;
+    std::vector<Verbosity> history;
+
+    auto cli
+        = Opt( verbosity, verbosities, "level" )
+            ["-v"]["--verbosity"]
+            ( "how much to say" )
+        | Opt( region, Choices<std::string>{ "eu-west", "us-east" }, "region" )
+            ["-r"]
+        | Arg( history, verbosities, "levels" );
+
+    SECTION( "enum" ) {
+        auto result = cli.parse( { "TestApp", "-v", "high" } );
+        REQUIRE( result );
+        REQUIRE( verbosity == Verbosity::High );
+    }
+    SECTION( "strings" ) {
+        auto result = cli.parse( { "TestApp", "-r", "us-east" } );
+        REQUIRE( result );
+        REQUIRE( region == "us-east" );
+    }
+    SECTION( "container" ) {
+        auto result = cli.parse( { "TestApp", "quiet", "high" } );
+        REQUIRE( result );
+        REQUIRE( history == std::vector<Verbosity>{ Verbosity::Quiet, Verbosity::High } );
+    }
+    SECTION( "invalid choice" ) {
+        auto result = cli.parse( { "TestApp", "-v", "loud" } );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "'loud' is not one of the valid choices" );
+        REQUIRE( verbosity == Verbosity::Normal );
+    }
+    SECTION( "duplicate choices" ) {
+        auto result = ( Parser() | Opt( region, Choices<std::string>{ "a", "b", "a" }, "region" )["-r"] )
+                .parse( { "TestApp", "-r", "a" } );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Choice names must be unique, but 'a' is repeated" );
+    }
+    SECTION( "many choices" ) {
+        std::vector<std::string> names;
+        for( int i = 0; i < 5000; ++i )
+            names.push_back( "region-" + std::to_string( i ) );
+        auto result = ( Parser() | Opt( region, Choices<std::string>( names ), "region" )["-r"] )
+                .parse( { "TestApp", "-r", "region-4321" } );
+        REQUIRE( result );
+        REQUIRE( region == "region-4321" );
+    }
+    SECTION( "usage lists the choices" ) {
+        REQUIRE_THAT( toString( cli ),
+                Contains( "how much to say (one of: quiet, normal, high)" ) &&
+                Contains( "(one of: eu-west, us-east)" ) );
+    }
+}
+
+#ifdef CLARA_CONFIG_PARSE_OBSERVER
+TEST_CASE( "parse observer" ) {
+
+    std::string name;
+    int count = 0;
+    bool flag = false;
+    std::vector<std::string> files;
+    int seen = 0;
+
+    ParseStatsObserver observer;
+    auto cli
+        = Opt( name, "name" )["-n"]
+        | Opt( count, "count" )["-c"]
+        | Opt( flag )["-f"]
+        | Opt( [&]( int i ) { seen = i; }, "seen" )["-s"]
+        | Arg( files, "files" );
+    cli.observer( &observer );
+
+    auto result = cli.parse( { "TestApp", "a", "-n", "Bill", "-c=3", "-f", "-s", "7", "b" } );
+    REQUIRE( result );
+    REQUIRE( seen == 7 );
+
+    auto stats = observer.snapshot();
+    CHECK( stats.tokensRead == 9 );
+    CHECK( stats.tokenBytes == 1 ); // Only the value of -c=3 is copied - the short name is shared
+    CHECK( stats.tokensDispatched == 6 );
+    CHECK( stats.maxParserAttemptsPerToken == 5 );
+    // Each Opt only matches once, so is not tried again after that
+    CHECK( stats.parserAttempts == 5 + 1 + 1 + 1 + 1 + 1 );
+    CHECK( stats.conversionsOf( ConversionKind::String ) == 3 );
+    CHECK( stats.conversionsOf( ConversionKind::Integral ) == 1 );
+    CHECK( stats.conversionsOf( ConversionKind::Flag ) == 1 );
+    CHECK( stats.conversionsOf( ConversionKind::Lambda ) == 1 );
+    CHECK( stats.timeIn( ParsePhase::Total ) >= stats.timeIn( ParsePhase::Tokenise ) + stats.timeIn( ParsePhase::Convert ) );
+
+    SECTION( "accumulates until reset" ) {
+        cli.parse( { "TestApp", "-f" } );
+        CHECK( observer.snapshot().conversionsOf( ConversionKind::Flag ) == 2 );
+        observer.reset();
+        CHECK( observer.snapshot().tokensRead == 0 );
+    }
+}
+#endif
+
+TEST_CASE( "shell completion" ) {
+    using namespace Catch::Matchers;
+
+    auto verbosity = Verbosity::Normal;
+    std::string name;
+    bool flag = false;
+    std::vector<std::string> files;
+
+    auto cli
+        = Opt( verbosity, Choices<Verbosity>{ { "quiet", Verbosity::Quiet }, { "high", Verbosity::High }, { "huge", Verbosity::High } }, "level" )
+            ["-v"]["--verbosity"]
+            ( "how much to say" )
+        | Opt( name, "name" )["-n"]["--name"]
+        | Opt( flag )["--no-colour"]
+        | Arg( files, "files" );
+    CompletionIndex index( cli );
+
+    auto values = []( CompletionResult const &result ) {
+        std::vector<std::string> values;
+        for( auto const &candidate : result.candidates )
+            values.push_back( candidate.value );
+        return values;
+    };
+
+    SECTION( "option names" ) {
+        auto result = index.complete( { "TestApp", "--n" }, 1 );
+        REQUIRE( values( result ) == ( std::vector<std::string>{ "--name", "--no-colour" } ) );
+        REQUIRE( result.hint.empty() );
+        REQUIRE( values( index.complete( { "TestApp", "-" }, 1 ) ).size() == 5 );
+        REQUIRE( index.complete( { "TestApp", "--verb" }, 1 ).candidates[0].description == "how much to say" );
+    }
+    SECTION( "choices for the previous option" ) {
+        auto result = index.complete( { "TestApp", "-v", "h" }, 2 );
+        REQUIRE( values( result ) == ( std::vector<std::string>{ "high", "huge" } ) );
+        REQUIRE( result.hint == "level" );
+        REQUIRE( values( index.complete( { "TestApp", "-v" }, 2 ) ).size() == 3 );
+    }
+    SECTION( "choices after '='" ) {
+        auto result = index.complete( { "TestApp", "--verbosity=q" }, 1 );
+        REQUIRE( values( result ) == std::vector<std::string>{ "--verbosity=quiet" } );
+    }
+    SECTION( "free values only give the hint" ) {
+        auto result = index.complete( { "TestApp", "--name", "" }, 2 );
+        REQUIRE( result.candidates.empty() );
+        REQUIRE( result.hint == "name" );
+        REQUIRE( index.complete( { "TestApp", "--no-colour", "" }, 2 ).hint.empty() );
+    }
+    SECTION( "nothing after '--'" ) {
+        REQUIRE( index.complete( { "TestApp", "--", "-" }, 2 ).candidates.empty() );
+    }
+    SECTION( "requests" ) {
+        std::ostringstream oss;
+        REQUIRE( handleCompletionRequest( cli, { "TestApp", "--clara-complete", "2", "TestApp", "-v", "q" }, oss ) );
+        REQUIRE( oss.str() == "quiet\t\n" );
+        REQUIRE_FALSE( handleCompletionRequest( cli, { "TestApp", "-v", "q" }, oss ) );
+    }
+    SECTION( "requests with the cursor out of range" ) {
+        std::ostringstream oss;
+        REQUIRE( handleCompletionRequest( cli, { "TestApp", "--clara-complete", "99999999999999999999999", "TestApp", "-" }, oss ) );
+        REQUIRE( handleCompletionRequest( cli, { "TestApp", "--clara-complete", "18446744073709551617", "TestApp", "-" }, oss ) );
+        REQUIRE( handleCompletionRequest( cli, { "TestApp", "--clara-complete", "3", "TestApp", "-" }, oss ) );
+        REQUIRE( oss.str().empty() );
+    }
+    SECTION( "scripts" ) {
+        REQUIRE_THAT( completionScript( Shell::Bash, "my-app" ),
+                Contains( "complete -F _my_app_clara_complete my-app" ) && Contains( "--clara-complete" )
+                && Contains( "COMP_CWORD" ) && !Contains( "read -ra" ) );
+        REQUIRE_THAT( completionScript( Shell::Zsh, "my-app" ), StartsWith( "#compdef my-app" ) );
+        REQUIRE_THAT( completionScript( Shell::Fish, "my-app" ), Contains( "complete -c my-app" ) );
+    }
+    SECTION( "bash candidates are not expanded as globs" ) {
+        REQUIRE_THAT( completionScript( Shell::Bash, "my-app" ),
+                Contains( "mapfile -t candidates < <(" ) && Contains( "mapfile -t COMPREPLY < <(compgen" ) && !Contains( "=( $(" ) );
+    }
+    SECTION( "names that need quoting" ) {
+        REQUIRE_THAT( completionScript( Shell::Bash, "my app;rm" ), Contains( "complete -F _my_app_rm_clara_complete 'my app;rm'\n" ) );
+        REQUIRE_THAT( completionScript( Shell::Bash, "it's" ), Contains( "complete -F _it_s_clara_complete 'it'\\''s'\n" ) );
+        REQUIRE_THAT( completionScript( Shell::Zsh, "my app" ), !StartsWith( "#compdef" ) && Contains( "compdef _my_app_clara_complete 'my app'\n" ) );
+        REQUIRE_THAT( completionScript( Shell::Fish, "it's\\" ), Contains( "complete -c 'it\\'s\\\\' -a" ) );
+    }
+    SECTION( "thousands of options" ) {
+        Parser big;
+        for( int i = 0; i < 5000; ++i )
+            big |= Opt( name, "value" )["--option-" + std::to_string( i )];
+        CompletionIndex bigIndex( big );
+        REQUIRE( bigIndex.complete( { "TestApp", "--option-432" }, 1 ).candidates.size() == 11 );
+        REQUIRE( bigIndex.complete( { "TestApp", "--option-4321" }, 1 ).candidates.size() == 1 );
+    }
+}
+
+// Each TAB press is a new process, so what the user waits on is building the index and
+// answering one request. Hidden, as wall-clock checks are noisy: see CLARA_TIMING_TESTS
+TEST_CASE( "completion latency", "[.][timing]" ) {
+    std::string name;
+    Parser big;
+    for( int i = 0; i < 5000; ++i )
+        big |= Opt( name, "value" )["--option-" + std::to_string( i )]( "option number " + std::to_string( i ) );
+
+    auto best = std::chrono::steady_clock::duration::max();
+    for( int run = 0; run < 5; ++run ) {
+        std::ostringstream oss;
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE( handleCompletionRequest( big, { "TestApp", "--clara-complete", "1", "TestApp", "--option-432" }, oss ) );
+        best = (std::min)( best, std::chrono::steady_clock::now() - start );
+        auto output = oss.str();
+        REQUIRE( std::count( output.begin(), output.end(), '\n' ) == 11 );
+    }
+    CHECK( best < std::chrono::milliseconds( 5 ) );
+}
+
+struct RecordingBindings : SchemaBindings {
+    std::vector<std::string> calls;
+
+    auto setValue( std::uint32_t slot, std::string const &arg ) -> ParserResult override {
+        calls.push_back( std::to_string( slot ) + "=" + arg );
+        return ParserResult::ok( ParseResultType::Matched );
+    }
+    auto setFlag( std::uint32_t slot ) -> ParserResult override {
+        calls.push_back( std::to_string( slot ) );
+        return ParserResult::ok( ParseResultType::Matched );
+    }
+};
+
+TEST_CASE( "parser schemas" ) {
+    std::string name;
+    int count = 0;
+    bool flag = false;
+    std::string region;
+    std::vector<std::string> files;
+    std::string target;
+
+    auto cli
+        = Opt( name, "name" )["-n"]["--name"]( "the name" )
+        | Opt( count, "count" )["-c"]["--count"].required()
+        | Opt( flag )["-f"]["--flag"]( "a flag" )
+        | Opt( region, Choices<std::string>{ "eu", "us" }, "region" )["-r"]
+        | Arg( target, "target" )
+        | Arg( files, "files" );
+    auto blob = serialiseSchema( cli );
+
+    auto loaded = SchemaView::load( blob.data(), blob.size() );
+    REQUIRE( loaded );
+    auto view = loaded.value();
+    REQUIRE( view.size() == 6 );
+
+    SECTION( "lookup" ) {
+        REQUIRE( view.slotOf( view.findOpt( "--count" ) ) == 1 );
+        REQUIRE( view.slotOf( view.findOpt( "-r" ) ) == 3 );
+        REQUIRE( view.findOpt( "--region" ) == view.size() );
+        REQUIRE( view.findOpt( "" ) == view.size() );
+    }
+    SECTION( "parse" ) {
+        RecordingBindings bindings;
+        auto result = view.parse( { "TestApp", "-f", "--name=Bill", "a", "b", "-c", "3", "c" }, bindings );
+        REQUIRE( result );
+        REQUIRE( bindings.calls == ( std::vector<std::string>{ "2", "0=Bill", "4=a", "5=b", "1=3", "5=c" } ) );
+    }
+    SECTION( "parse errors" ) {
+        RecordingBindings bindings;
+        auto result = view.parse( { "TestApp", "--nope" }, bindings );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Unrecognised token: --nope" );
+        result = view.parse( { "TestApp", "-n" }, bindings );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Expected argument following -n" );
+    }
+    SECTION( "help matches the parser" ) {
+        std::ostringstream oss;
+        oss << view;
+        auto help = toString( cli );
+        REQUIRE( help.substr( help.find( "where options are:\n" ) + 19 ) == oss.str() );
+    }
+    SECTION( "stale snapshots" ) {
+        REQUIRE( SchemaView::load( blob.data(), blob.size(), view.hash() ) );
+        auto result = SchemaView::load( blob.data(), blob.size(), view.hash() + 1 );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Parser schema is stale" );
+    }
+    SECTION( "corrupt snapshots" ) {
+        REQUIRE( SchemaView::load( blob.data(), blob.size() - 1 ).errorMessage() == "Parser schema is corrupt" );
+        REQUIRE( SchemaView::load( blob.data(), 3 ).errorMessage() == "Not a parser schema" );
+        blob[blob.size() - 1] ^= 1;
+        REQUIRE( SchemaView::load( blob.data(), blob.size() ).errorMessage() == "Parser schema is corrupt" );
+    }
+    SECTION( "position independent" ) {
+        std::vector<char> copy( blob.begin(), blob.end() );
+        copy.insert( copy.begin(), 'x' ); // Misaligned
+        auto moved = SchemaView::load( copy.data() + 1, blob.size() );
+        REQUIRE( moved );
+        REQUIRE( moved.value().findOpt( "--flag" ) == 2 );
+    }
+}
+
+TEST_CASE( "help search" ) {
+    bool showHelp = false, colour = false, verbose = false;
+    std::string searchTerm, output, format;
+
+    auto cli
+        = Help( showHelp, searchTerm )
+        | Opt( colour )["--colour"]( "use colours in the output" )
+        | Opt( output, "file" )["-o"]["--output"]( "where to write the results" )
+        | Opt( format, "format" )["--output-format"]( "the format of the output" )
+        | Opt( verbose )["-v"]["--verbose"]( "say more about progress" );
+
+    auto lefts = []( std::vector<clara::detail::HelpColumns> const &rows ) {
+        std::vector<std::string> lefts;
+        for( auto const &row : rows )
+            lefts.push_back( row.left );
+        return lefts;
+    };
+
+    SECTION( "names rank above descriptions" ) {
+        REQUIRE( lefts( cli.search( "output" ) ) == ( std::vector<std::string>{
+            "-o, --output <file>", "--output-format <format>", "--colour" } ) );
+    }
+    SECTION( "prefixes" ) {
+        REQUIRE( lefts( cli.search( "verb" ) ) == std::vector<std::string>{ "-v, --verbose" } );
+        REQUIRE( lefts( cli.search( "PROG" ) ) == std::vector<std::string>{ "-v, --verbose" } );
+    }
+    SECTION( "every word must match" ) {
+        REQUIRE( lefts( cli.search( "output format" ) ) == std::vector<std::string>{ "--output-format <format>" } );
+        REQUIRE( cli.search( "output nothing" ).empty() );
+    }
+    SECTION( "an empty search matches everything" ) {
+        REQUIRE( cli.search( "" ).size() == 5 );
+    }
+    SECTION( "the index is rebuilt when options are added" ) {
+        REQUIRE( cli.search( "quiet" ).empty() );
+        cli |= Opt( verbose )["-q"]["--quiet"];
+        REQUIRE( cli.search( "quiet" ).size() == 1 );
+    }
+    SECTION( "uses the help layout" ) {
+        std::ostringstream oss;
+        cli.writeSearchToStream( oss, "colour" );
+        REQUIRE( oss.str() == "  --colour    use colours in the output\n" );
+    }
+    SECTION( "--help <term>" ) {
+        auto result = cli.parse( { "TestApp", "--help", "output" } );
+        REQUIRE( result );
+        REQUIRE( result.value().type() == ParseResultType::ShortCircuitAll );
+        REQUIRE( showHelp );
+        REQUIRE( searchTerm == "output" );
+    }
+    SECTION( "--help on its own" ) {
+        auto result = cli.parse( { "TestApp", "--verbose", "--help", "--colour" } );
+        REQUIRE( result );
+        REQUIRE( showHelp );
+        REQUIRE( searchTerm.empty() );
+    }
+    SECTION( "thousands of options" ) {
+        Parser big;
+        for( int i = 0; i < 10000; ++i )
+            big |= Opt( output, "value" )["--option-" + std::to_string( i )]( "sets value number " + std::to_string( i ) );
+        REQUIRE( big.search( "number 1234" ).size() == 1 ); // Builds the index
+        REQUIRE( big.search( "option 9999" ).size() == 1 );
+        REQUIRE( big.search( "option 99" ).size() == 111 );
+    }
+    SECTION( "searches from several threads" ) {
+        std::vector<size_t> found( 4 );
+        std::vector<std::thread> threads;
+        for( size_t i = 0; i < found.size(); ++i )
+            threads.emplace_back( [&, i] { found[i] = cli.search( "output" ).size(); } );
+        for( auto &thread : threads )
+            thread.join();
+        REQUIRE( found == ( std::vector<size_t>{ 3, 3, 3, 3 } ) );
+    }
+}
+
+// Hidden, as wall-clock checks are noisy: see CLARA_TIMING_TESTS
+TEST_CASE( "help search latency", "[.][timing]" ) {
+    std::string value;
+    Parser big;
+    for( int i = 0; i < 10000; ++i )
+        big |= Opt( value, "value" )["--option-" + std::to_string( i )]( "sets value number " + std::to_string( i ) );
+    REQUIRE( big.search( "number 1234" ).size() == 1 ); // Builds the index
+
+    auto start = std::chrono::steady_clock::now();
+    for( int i = 0; i < 100; ++i )
+        REQUIRE( big.search( "option 9999" ).size() == 1 );
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK( elapsed < std::chrono::milliseconds( 100 ) );
+}
+
+TEST_CASE( "utf-8 in help" ) {
+    using TextFlow::Column;
+    using TextFlow::Spacer;
+    using TextFlow::displayWidth;
+
+    SECTION( "display width" ) {
+        REQUIRE( displayWidth( "plain" ) == 5 );
+        REQUIRE( displayWidth( "10\xc2\xb5s" ) == 4 );                  // 10µs
+        REQUIRE( displayWidth( "\xe6\x97\xa5\xe6\x9c\xac" ) == 4 );     // 日本 - wide
+        REQUIRE( displayWidth( "e\xcc\x81" ) == 1 );                    // e + combining acute
+        REQUIRE( displayWidth( "\xff" ) == 1 );                         // Invalid
+    }
+    SECTION( "wraps by display width" ) {
+        // Each µ is two bytes but one column, so the whole line fits
+        REQUIRE( Column( "\xc2\xb5\xc2\xb5\xc2\xb5 \xc2\xb5\xc2\xb5\xc2\xb5" ).width( 8 ).toString()
+                == "\xc2\xb5\xc2\xb5\xc2\xb5 \xc2\xb5\xc2\xb5\xc2\xb5" );
+        REQUIRE( Column( "\xc2\xb5\xc2\xb5\xc2\xb5 \xc2\xb5\xc2\xb5\xc2\xb5" ).width( 5 ).toString()
+                == "\xc2\xb5\xc2\xb5\xc2\xb5\n\xc2\xb5\xc2\xb5\xc2\xb5" );
+    }
+    SECTION( "never splits a code point" ) {
+        auto text = std::string( "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e" ); // 日本語日本語
+        auto column = Column( text ).width( 5 );
+        for( auto line : column ) {
+            REQUIRE( displayWidth( line ) <= 5 );
+            if( line.back() == '-' ) // Hyphenated, as there are no spaces to break at
+                line.pop_back();
+            REQUIRE( ( static_cast<unsigned char>( line.back() ) & 0xc0 ) == 0x80 ); // Ends in a continuation byte
+        }
+        auto narrow = Column( text ).width( 2 );
+        for( auto const &line : narrow )
+            REQUIRE( line.size() >= 3 ); // At least one whole character per line
+    }
+    SECTION( "aligns columns" ) {
+        auto rows = ( Column( "\xc2\xb5s" ).width( 6 ) + Spacer( 2 ) + Column( "unit" ).width( 10 ) ).toString();
+        REQUIRE( rows == "\xc2\xb5s      unit" );
+    }
+    SECTION( "aligns options" ) {
+        std::string value;
+        auto cli = Opt( value, "\xc2\xb5s" )["-t"]( "timeout" ) | Opt( value, "ms" )["-u"]( "other" );
+        auto help = toString( cli );
+        REQUIRE( help.find( "-t <\xc2\xb5s>    timeout" ) != std::string::npos );
+        REQUIRE( help.find( "-u <ms>    other" ) != std::string::npos );
+    }
+}
+
+#ifdef CLARA_CONFIG_PARALLEL_CONVERSION
+struct UnluckyNumber {
+    int value = 0;
+};
+auto operator>>( std::istream &is, UnluckyNumber &number ) -> std::istream & {
+    is >> number.value;
+    if( number.value >= 10000 )
+        throw std::runtime_error( "unlucky " + std::to_string( number.value ) );
+    return is;
+}
+
+TEST_CASE( "parallel conversion" ) {
+    std::vector<int> numbers;
+    bool flag = false;
+    auto cli
+        = Opt( flag )["-f"]
+        | Arg( numbers, "numbers" ).parallel( 4 );
+
+    std::vector<std::string> args{ "TestApp" };
+    for( int i = 0; i < 10000; ++i )
+        args.push_back( std::to_string( i ) );
+    auto parse = [&]() {
+        std::vector<char const *> argv;
+        for( auto const &arg : args )
+            argv.push_back( arg.c_str() );
+        return cli.parse( Args( static_cast<int>( argv.size() ), argv.data() ) );
+    };
+
+    SECTION( "preserves order" ) {
+        args.insert( args.begin() + 5000, "-f" );
+        args.insert( args.begin() + 7000, "" );
+        auto result = parse();
+        REQUIRE( result );
+        REQUIRE( flag );
+        REQUIRE( numbers.size() == 10000 );
+        bool inOrder = true;
+        for( int i = 0; i < 10000; ++i )
+            inOrder = inOrder && numbers[static_cast<size_t>( i )] == i;
+        REQUIRE( inOrder );
+    }
+    SECTION( "reports the first error" ) {
+        args[9001] = "nine";
+        args[2501] = "two";
+        auto result = parse();
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Unable to convert 'two' to destination type" );
+        REQUIRE( numbers.size() == 2500 );
+    }
+    SECTION( "after --" ) {
+        args.insert( args.begin() + 1, "--" );
+        args.push_back( "-1" );
+        auto result = parse();
+        REQUIRE( result );
+        REQUIRE( numbers.size() == 10001 );
+        REQUIRE( numbers.back() == -1 );
+    }
+    SECTION( "exceptions are rethrown from the earliest argument" ) {
+        std::vector<UnluckyNumber> unlucky;
+        auto unluckyCli = Parser() | Arg( unlucky, "numbers" ).parallel( 4 );
+        args[8001] = "20000";
+        args[3002] = "30000";
+        std::vector<char const *> argv;
+        for( auto const &arg : args )
+            argv.push_back( arg.c_str() );
+
+        try {
+            unluckyCli.parse( Args( static_cast<int>( argv.size() ), argv.data() ) );
+            FAIL( "expected an exception" );
+        }
+        catch( std::runtime_error const &ex ) {
+            CHECK( std::string( ex.what() ) == "unlucky 30000" );
+        }
+        CHECK( unlucky.empty() );
+        REQUIRE( parse() ); // The pool is still usable
+        REQUIRE( numbers.size() == 10000 );
+    }
+    SECTION( "few arguments are converted serially" ) {
+        auto result = cli.parse( { "TestApp", "1", "-f", "2" } );
+        REQUIRE( result );
+        REQUIRE( numbers == ( std::vector<int>{ 1, 2 } ) );
+    }
+}
+#endif
+
+TEST_CASE( "short option clusters" ) {
+    bool a = false, b = false;
+    int jobs = 0;
+    std::string output;
+    std::string define;
+    auto cli
+        = Opt( a )["-a"]
+        | Opt( b )["-b"]
+        | Opt( jobs, "jobs" )["-j"]["--jobs"]
+        | Opt( output, "file" )["-o"]
+        | Opt( define, "name=value" )["-D"];
+
+    SECTION( "flags" ) {
+        REQUIRE( cli.parse( { "TestApp", "-ab" } ) );
+        REQUIRE( a );
+        REQUIRE( b );
+    }
+    SECTION( "attached values" ) {
+        REQUIRE( cli.parse( { "TestApp", "-j8", "-ofile" } ) );
+        REQUIRE( jobs == 8 );
+        REQUIRE( output == "file" );
+    }
+    SECTION( "flags then an attached value" ) {
+        REQUIRE( cli.parse( { "TestApp", "-abofile" } ) );
+        REQUIRE( a );
+        REQUIRE( b );
+        REQUIRE( output == "file" );
+    }
+    SECTION( "the rest of the cluster is the value, even if it looks like options" ) {
+        REQUIRE( cli.parse( { "TestApp", "-oab" } ) );
+        REQUIRE( output == "ab" );
+        REQUIRE_FALSE( a );
+    }
+    SECTION( "attached values containing delimiters" ) {
+        REQUIRE( cli.parse( { "TestApp", "-ofoo=bar", "-Dname=value" } ) );
+        REQUIRE( output == "foo=bar" );
+        REQUIRE( define == "name=value" );
+        REQUIRE( cli.parse( { "TestApp", "-o/a:/b" } ) );
+        REQUIRE( output == "/a:/b" );
+        REQUIRE( cli.parse( { "TestApp", "-abox y=z" } ) );
+        REQUIRE( b );
+        REQUIRE( output == "x y=z" );
+    }
+    SECTION( "a delimiter straight after the option still separates its value" ) {
+        REQUIRE( cli.parse( { "TestApp", "-o=file", "-D:name=value" } ) );
+        REQUIRE( output == "file" );
+        REQUIRE( define == "name=value" );
+    }
+    SECTION( "value in the next arg" ) {
+        REQUIRE( cli.parse( { "TestApp", "-abj", "4" } ) );
+        REQUIRE( jobs == 4 );
+    }
+    SECTION( "a standalone Opt" ) {
+        auto result = Opt( jobs, "jobs" )["-j"].parse( Args{ "TestApp", "-j8" } );
+        REQUIRE( result );
+        REQUIRE( jobs == 8 );
+        REQUIRE( Opt( a )["-a"].parse( Args{ "TestApp", "-a8" } ) ); // Flags take no value, so -8 is left
+        REQUIRE( a );
+    }
+    SECTION( "unknown options in a cluster" ) {
+        auto result = cli.parse( { "TestApp", "-a8" } );
+        REQUIRE( !result );
+        REQUIRE( result.errorMessage() == "Unrecognised token: -8" );
+    }
+    SECTION( "static parsers" ) {
+        std::string name;
+        bool flag = false;
+        double number = 0;
+        std::vector<std::string> files;
+        auto parser = makeStaticParser( staticSpecs, name, flag, number, files );
+        REQUIRE( parser.parse( { "TestApp", "-fnBill" } ) );
+        REQUIRE( flag );
+        REQUIRE( name == "Bill" );
+    }
+    SECTION( "schemas" ) {
+        auto blob = serialiseSchema( cli );
+        RecordingBindings bindings;
+        REQUIRE( SchemaView::load( blob.data(), blob.size() ).value().parse( { "TestApp", "-bj16" }, bindings ) );
+        REQUIRE( bindings.calls == ( std::vector<std::string>{ "1", "2=16" } ) );
+    }
+}
+
+TEST_CASE( "token table" ) {
+    detail::ShortValueOpts shortValueOpts;
+    shortValueOpts.add( "-o" );
+    Args args{ "TestApp", "-ab", "--name=Bill", "", "-ofile", "a very long positional argument", "--", "-x" };
+    detail::TokenTable table( args, shortValueOpts );
+
+    REQUIRE( table.size() == 8 );
+    CHECK( table.endOfOptions() == 7 );
+
+    struct Expected { detail::TokenType type; char const *text; size_t source; };
+    Expected const expected[] = {
+        { detail::TokenType::Option, "-a", 0 }, { detail::TokenType::Option, "-b", 0 },
+        { detail::TokenType::Option, "--name", 1 }, { detail::TokenType::Argument, "Bill", 1 },
+        { detail::TokenType::Option, "-o", 3 }, { detail::TokenType::Argument, "file", 3 },
+        { detail::TokenType::Argument, "a very long positional argument", 4 },
+        { detail::TokenType::Argument, "-x", 6 }
+    };
+    for( size_t i = 0; i < table.size(); ++i ) {
+        CHECK( table.type( i ) == expected[i].type );
+        CHECK( table.text( i ) == expected[i].text );
+        CHECK( table.source( i ) == expected[i].source );
+    }
+
+    SECTION( "whole args are not copied" ) {
+        CHECK( table.isWholeArg( 6 ) );
+        CHECK( &table.text( 6 ) == &table.args()[4] );
+        CHECK_FALSE( table.isWholeArg( 3 ) );
+    }
+    SECTION( "copies of a stream index into the same table" ) {
+        detail::TokenStream tokens( table );
+        ++tokens;
+        auto saved = tokens;
+        ++tokens;
+        ++tokens;
+        CHECK( tokens->token == "Bill" );
+        CHECK( saved->token == "-b" );
+        CHECK( saved.count() == 7 );
+        CHECK( &(*saved).token == &table.text( 1 ) );
+    }
+    SECTION( "a stream can skip to the run of args after --" ) {
+        detail::TokenStream tokens( table );
+        tokens.skipTo( table.args().begin() + 6 );
+        CHECK( tokens.isPastEndOfOptions() );
+        CHECK( tokens->token == "-x" );
+    }
+}
+
+TEST_CASE( "collecting errors" ) {
+    int count = 0;
+    std::string name, output;
+    bool flag = false;
+    std::vector<int> numbers;
+    auto cli
+        = Opt( count, "count" )["-c"]["--count"]
+        | Opt( name, "name" )["-n"]
+        | Opt( output, "file" )["-o"].required()
+        | Opt( flag )["-f"]
+        | Arg( numbers, "numbers" );
+
+    SECTION( "a good command line has no diagnostics" ) {
+        auto result = cli.parseCollectingErrors( { "TestApp", "-c", "3", "-o", "out", "1", "2" } );
+        REQUIRE( result );
+        CHECK( result.value().empty() );
+        CHECK( count == 3 );
+        CHECK( numbers == std::vector<int>{ 1, 2 } );
+    }
+    SECTION( "every error is found, in one pass" ) {
+        auto result = cli.parseCollectingErrors( { "TestApp", "-c", "three", "--wat", "1", "x", "-f", "2", "-n" } );
+        REQUIRE( result );
+        auto const &diagnostics = result.value();
+        REQUIRE( diagnostics.size() == 5 );
+
+        CHECK( diagnostics[0].kind == DiagnosticKind::ConversionFailed );
+        CHECK( diagnostics[0].token == 1 ); // The value at fault, rather than its option
+        CHECK( diagnostics[0].arg == 2 );
+        CHECK( diagnostics[1].kind == DiagnosticKind::UnrecognisedToken );
+        CHECK( diagnostics[1].token == 2 );
+        CHECK( diagnostics[1].message == "Unrecognised token: --wat" );
+        CHECK( diagnostics[2].kind == DiagnosticKind::ConversionFailed );
+        CHECK( diagnostics[2].arg == 5 );
+        CHECK( diagnostics[3].kind == DiagnosticKind::MissingArgument );
+        CHECK( diagnostics[3].arg == 8 );
+        CHECK( diagnostics[4].kind == DiagnosticKind::MissingRequired );
+        CHECK( diagnostics[4].message == "Missing required option: -o" );
+        CHECK( diagnostics[4].token == 8 );
+
+        // Everything else was still parsed
+        CHECK( flag );
+        CHECK( numbers == std::vector<int>{ 1, 2 } );
+    }
+    SECTION( "split args report the arg they came from" ) {
+        auto result = cli.parseCollectingErrors( { "TestApp", "-o", "out", "--count=lots" } );
+        REQUIRE( result );
+        REQUIRE( result.value().size() == 1 );
+        CHECK( result.value()[0].token == 3 ); // lots, split from --count
+        CHECK( result.value()[0].arg == 3 );
+    }
+    SECTION( "a value that fails to convert is the token at fault" ) {
+        auto result = cli.parseCollectingErrors( { "TestApp", "-o", "out", "-c", "abc", "--bogus", "-f" } );
+        REQUIRE( result );
+        auto const &diagnostics = result.value();
+        REQUIRE( diagnostics.size() == 2 );
+        CHECK( diagnostics[0].kind == DiagnosticKind::ConversionFailed );
+        CHECK( diagnostics[0].token == 3 );
+        CHECK( diagnostics[0].arg == 4 );
+        CHECK( diagnostics[1].kind == DiagnosticKind::UnrecognisedToken );
+        CHECK( diagnostics[1].token == 4 );
+        CHECK( diagnostics[1].arg == 5 );
+        CHECK( flag );
+    }
+    SECTION( "an invalid parser is still an error" ) {
+        auto result = ( cli | Opt( flag )[""] ).parseCollectingErrors( { "TestApp", "--wat" } );
+        CHECK_FALSE( result );
+    }
+}
+
+TEST_CASE( "parse sessions" ) {
+    std::string name = "nobody";
+    int count = 1;
+    bool verbose = false;
+    std::vector<std::string> files;
+    auto cli
+        = Opt( name, "name" )["-n"]
+        | Opt( count, "count" )["-c"]
+        | Opt( verbose )["-v"]
+        | Arg( files, "files" );
+
+    ParseSession session( cli );
+
+    REQUIRE( session.parse( { "TestApp", "-n", "Bill", "-c=3", "-v", "a", "b" } ) );
+    CHECK( name == "Bill" );
+    CHECK( count == 3 );
+    CHECK( verbose );
+    CHECK( files.size() == 2 );
+
+    SECTION( "each parse starts from the defaults" ) {
+        REQUIRE( session.parse( { "TestApp", "c" } ) );
+        CHECK( name == "nobody" );
+        CHECK( count == 1 );
+        CHECK_FALSE( verbose );
+        CHECK( files == std::vector<std::string>{ "c" } );
+    }
+    SECTION( "defaults can be restored without parsing" ) {
+        session.reset();
+        CHECK( name == "nobody" );
+        CHECK( files.empty() );
+    }
+    SECTION( "a failed parse can be followed by a good one" ) {
+        REQUIRE_FALSE( session.parse( { "TestApp", "-c", "many" } ) );
+        REQUIRE( session.parse( { "TestApp", "-c", "2" } ) );
+        CHECK( count == 2 );
+        CHECK( name == "nobody" );
+    }
+}
+
+TEST_CASE( "parse sessions reset help" ) {
+    bool showHelp = false;
+    std::string searchTerm;
+    std::string name;
+    ParseSession session( Help( showHelp, searchTerm ) | Opt( name, "name" )["-n"] );
+
+    REQUIRE( session.parse( { "TestApp", "--help", "foo" } ) );
+    CHECK( showHelp );
+    CHECK( searchTerm == "foo" );
+
+    REQUIRE( session.parse( { "TestApp", "-h" } ) );
+    CHECK( showHelp );
+    CHECK( searchTerm.empty() );
+
+    REQUIRE( session.parse( { "TestApp", "-n", "Bill" } ) );
+    CHECK_FALSE( showHelp );
+    CHECK( searchTerm.empty() );
+    CHECK( name == "Bill" );
+}
+
+TEST_CASE( "splitting a command line" ) {
+    auto words = []( std::string const &commandLine ) -> std::vector<std::string> {
+        std::vector<std::string> result;
+        auto args = splitCommandLine( commandLine );
+        REQUIRE( args );
+        result.push_back( args.value().exeName() );
+        auto cli = Parser() | Arg( result, "words" );
+        REQUIRE( cli.parse( args.value() ) );
+        return result;
+    };
+
+    CHECK( words( "app  one\ttwo\n" ) == std::vector<std::string>{ "app", "one", "two" } );
+    CHECK( words( "app 'single quoted' \"double quoted\"" ) == std::vector<std::string>{ "app", "single quoted", "double quoted" } );
+    CHECK( words( "app it\\'s a\\ b" ) == std::vector<std::string>{ "app", "it's", "a b" } );
+    CHECK( words( "app pre'fix'ed \"\\$HOME \\n\"" ) == std::vector<std::string>{ "app", "prefixed", "$HOME \\n" } );
+    CHECK( words( "app 'no \\escapes'" ) == std::vector<std::string>{ "app", "no \\escapes" } );
+    CHECK( words( "app con\\\ntinued \\\n last" ) == std::vector<std::string>{ "app", "continued", "last" } );
+    CHECK( words( "app one\r\ntwo\r\n" ) == std::vector<std::string>{ "app", "one", "two" } );
+    CHECK( words( "app\vone\ftwo" ) == std::vector<std::string>{ "app", "one", "two" } );
+
+    SECTION( "empty quotes give an empty value" ) {
+        auto args = splitCommandLine( "app --name=''" );
+        REQUIRE( args );
+        std::string name = "unset";
+        REQUIRE( Opt( name, "name" )["--name"].parse( args.value() ) );
+        CHECK( name.empty() );
+    }
+    SECTION( "feeds straight into a parser" ) {
+        int count = 0;
+        std::string name;
+        auto cli = Opt( count, "count" )["-c"] | Opt( name, "name" )["--name"];
+        auto args = splitCommandLine( "admin -c 3 --name='Darth Vader'" );
+        REQUIRE( args );
+        REQUIRE( cli.parse( args.value() ) );
+        CHECK( count == 3 );
+        CHECK( name == "Darth Vader" );
+    }
+    SECTION( "errors" ) {
+        CHECK_FALSE( splitCommandLine( "app 'open" ) );
+        CHECK_FALSE( splitCommandLine( "app \"open\\\"" ) );
+        CHECK_FALSE( splitCommandLine( "app trailing\\" ) );
+        CHECK_FALSE( splitCommandLine( " \t" ) );
+    }
+}
+
+TEST_CASE( "option constraints" ) {
+    std::string input, key, cert, user, password;
+    bool useStdin = false, verbose = false;
+    auto cli
+        = ( Opt( input, "file" )["-i"]["--input"]
+        | Opt( useStdin )["--stdin"]
+        | Opt( key, "file" )["--tls-key"]
+        | Opt( cert, "file" )["--tls-cert"]
+        | Opt( user, "name" )["--user"]
+        | Opt( password, "secret" )["--password"]
+        | Opt( verbose )["-v"] )
+        .exclusive( { "--input", "--stdin" } )
+        .atLeastOne( { "--input", "--stdin" } )
+        .dependsOn( "--tls-key", { "--tls-cert" } )
+        .allOrNone( { "--user", "--password" } );
+
+    SECTION( "satisfied" ) {
+        CHECK( cli.parse( { "TestApp", "-i", "in.txt" } ) );
+        CHECK( cli.parse( { "TestApp", "--stdin", "--tls-key", "k", "--tls-cert", "c" } ) );
+        CHECK( cli.parse( { "TestApp", "--stdin", "--tls-cert", "c", "--user", "u", "--password", "p" } ) );
+    }
+    SECTION( "exclusive" ) {
+        auto result = cli.parse( { "TestApp", "-i", "in.txt", "--stdin" } );
+        REQUIRE_FALSE( result );
+        CHECK( result.errorMessage() == "Only one of --input, --stdin may be given" );
+    }
+    SECTION( "at least one" ) {
+        auto result = cli.parse( { "TestApp", "-v" } );
+        REQUIRE_FALSE( result );
+        CHECK( result.errorMessage() == "One of --input, --stdin is required" );
+    }
+    SECTION( "every violation is reported" ) {
+        auto result = cli.parse( { "TestApp", "--tls-key", "k", "--password", "p" } );
+        REQUIRE_FALSE( result );
+        CHECK( result.errorMessage() ==
+            "One of --input, --stdin is required\n"
+            "--tls-key requires --tls-cert\n"
+            "--user, --password must be given together" );
+    }
+    SECTION( "as diagnostics" ) {
+        auto result = cli.parseCollectingErrors( { "TestApp", "--stdin", "--user", "u" } );
+        REQUIRE( result );
+        REQUIRE( result.value().size() == 1 );
+        CHECK( result.value()[0].kind == DiagnosticKind::ConstraintViolated );
+        CHECK( result.value()[0].token == 3 );
+    }
+    SECTION( "merged parsers keep their constraints" ) {
+        auto merged = Parser() | Opt( verbose )["-q"] | cli;
+        CHECK_FALSE( merged.parse( { "TestApp", "-q" } ) );
+        CHECK( merged.parse( { "TestApp", "-q", "--stdin" } ) );
+    }
+    SECTION( "merged constraints stay with their own options, even if names are shared" ) {
+        bool baseVerbose = false, subVerbose = false, y = false;
+        auto sub = ( Opt( subVerbose )["-v"]["--verbose-sub"] | Opt( y )["-y"] ).exclusive( { "-v", "-y" } );
+        auto merged = Parser() | Opt( baseVerbose )["-v"] | sub;
+
+        auto result = merged.parse( { "TestApp", "--verbose-sub", "-y" } );
+        REQUIRE_FALSE( result );
+        CHECK( result.errorMessage() == "Only one of -v, -y may be given" );
+        CHECK( merged.parse( { "TestApp", "-v", "-y" } ) ); // -v is the base parser's option
+        CHECK( baseVerbose );
+    }
+    SECTION( "unknown names are a logic error" ) {
+        auto bad = Parser( cli ).exclusive( { "--input", "--output" } );
+        CHECK_FALSE( bad.validate() );
+        auto result = bad.parse( { "TestApp", "--stdin" } );
+        REQUIRE_FALSE( result );
+        CHECK( result.type() == detail::ResultBase::LogicError );
+    }
+    SECTION( "options past the 512th can be constrained" ) {
+        std::unique_ptr<bool[]> flags( new bool[1200]() );
+        Parser big;
+        for( size_t i = 0; i < 1200; ++i )
+            big |= Opt( flags[i] )["--opt-" + std::to_string( i )];
+        big.exclusive( { "--opt-1", "--opt-1100" } )
+            .dependsOn( "--opt-700", { "--opt-1199" } );
+        REQUIRE( big.validate() );
+
+        REQUIRE( big.parse( { "TestApp", "--opt-1100", "--opt-2" } ) );
+        CHECK( flags[1100] );
+        REQUIRE( big.parse( { "TestApp", "--opt-700", "--opt-1199" } ) );
+
+        auto result = big.parse( { "TestApp", "--opt-1100", "--opt-1", "--opt-700" } );
+        REQUIRE_FALSE( result );
+        CHECK( result.errorMessage() == "Only one of --opt-1, --opt-1100 may be given\n--opt-700 requires --opt-1199" );
+    }
+}
+
+TEST_CASE( "lazy descriptions and hidden options" ) {
+    std::string name;
+    bool debug = false, verbose = false;
+    int built = 0;
+    auto cli
+        = Opt( name, "name" )["-n"]( "the name to use" )
+        | Opt( verbose )["-v"].describedBy( [&] { ++built; return std::string( "be chatty" ); } )
+        | Opt( debug )["--debug"]( "internal use only" ).hidden();
+
+    SECTION( "callbacks only run when help is rendered" ) {
+        REQUIRE( cli.parse( { "TestApp", "-v", "-n", "Bill" } ) );
+        CHECK( built == 0 );
+        auto help = toString( cli );
+        CHECK( built == 1 );
+        CHECK( help.find( "be chatty" ) != std::string::npos );
+        CHECK( help.find( "the name to use" ) != std::string::npos );
+    }
+    SECTION( "completion only describes the candidates" ) {
+        CompletionIndex index( cli );
+        CHECK( built == 0 );
+        REQUIRE( index.complete( { "TestApp", "-n" }, 1 ).candidates.size() == 1 );
+        CHECK( built == 0 );
+        auto result = index.complete( { "TestApp", "-v" }, 1 );
+        REQUIRE( result.candidates.size() == 1 );
+        CHECK( result.candidates[0].description == "be chatty" );
+        CHECK( built == 1 );
+    }
+    SECTION( "hidden options are parsed, but not shown" ) {
+        REQUIRE( cli.parse( { "TestApp", "--debug" } ) );
+        CHECK( debug );
+        CHECK( cli.getHelpColumns().size() == 2 );
+        CHECK( toString( cli ).find( "--debug" ) == std::string::npos );
+        CHECK( cli.search( "internal" ).empty() );
+        CHECK( CompletionIndex( cli ).complete( { "--d" }, 0 ).candidates.empty() );
+    }
+    SECTION( "hidden options stay hidden in schemas" ) {
+        auto schema = serialiseSchema( cli );
+        auto view = SchemaView::load( schema.data(), schema.size() );
+        REQUIRE( view );
+        CHECK( view.value().getHelpColumns().size() == 2 );
+    }
+}
+
+TEST_CASE( "literal and runtime text" ) {
+    std::string name;
+    int count = 0;
+
+    SECTION( "runtime-built names, hints and descriptions are copied" ) {
+        std::string longName = "--name";
+        std::string hint = "name";
+        char const *description = "the name to use";
+        auto cli = Parser() | Opt( name, hint )[longName]( description );
+        longName = "--other";
+        hint.clear();
+
+        REQUIRE( cli.parse( { "TestApp", "--name", "Bill" } ) );
+        CHECK( name == "Bill" );
+        auto help = toString( cli );
+        CHECK( help.find( "--name <name>" ) != std::string::npos );
+        CHECK( help.find( "the name to use" ) != std::string::npos );
+    }
+    SECTION( "mutable buffers are copied, rather than treated as literals" ) {
+        char buffer[16] = "--count";
+        auto cli = Parser() | Opt( count, "count" )[buffer];
+        std::strcpy( buffer, "--other" );
+
+        REQUIRE( cli.parse( { "TestApp", "--count", "3" } ) );
+        CHECK( count == 3 );
+    }
+    SECTION( "const arrays are copied too" ) {
+        auto make = [&] {
+            char const longName[] = "--count";
+            return Parser() | Opt( count, "count" )[longName];
+        };
+        auto cli = make(); // The array has gone
+
+        REQUIRE( cli.parse( { "TestApp", "--count", "3" } ) );
+        CHECK( count == 3 );
+    }
+    SECTION( "literals can be referred to instead" ) {
+        auto cli = Parser() | Opt( count, literal( "count" ) )[literal( "-c" )][literal( "--count" )]( literal( "how many" ) );
+
+        REQUIRE( cli.parse( { "TestApp", "-c", "3" } ) );
+        CHECK( count == 3 );
+        CHECK( toString( cli ).find( "-c, --count <count>    how many" ) != std::string::npos );
+    }
+#ifdef CLARA_CONFIG_STRING_VIEW
+    SECTION( "string_views are referred to" ) {
+        char const text[] = "--name=the name to use";
+        std::string_view view = text;
+        auto cli = Parser() | Opt( name, view.substr( 2, 4 ) )[view.substr( 0, 6 )]( view.substr( 7 ) );
+
+        REQUIRE( cli.parse( { "TestApp", "--name", "Bill" } ) );
+        CHECK( name == "Bill" );
+        CHECK( toString( cli ).find( "--name <name>    the name to use" ) != std::string::npos );
+    }
+#endif
+}
+
+TEST_CASE( "type-erased bindings" ) {
+    SECTION( "integers of each width are range checked" ) {
+        unsigned short small = 0;
+        long long big = 0;
+        auto cli = Parser()
+            | Opt( small, "small" )["--small"]
+            | Opt( big, "big" )["--big"];
+
+        std::vector<short> shorts;
+        auto shortCli = Parser() | Opt( shorts, "short" )["--short"].delimiter( ',' );
+        REQUIRE( shortCli.parse( { "TestApp", "--short=-32768,32767" } ) );
+        REQUIRE( shorts.size() == 2 );
+        CHECK( shorts[0] == -32768 );
+        CHECK( shorts[1] == 32767 );
+        CHECK( !shortCli.parse( { "TestApp", "--short=32768" } ) );
+
+        std::vector<unsigned short> smalls;
+        auto smallCli = Parser() | Opt( smalls, "small" )["--small"].delimiter( ',' );
+        REQUIRE( smallCli.parse( { "TestApp", "--small=65535" } ) );
+        CHECK( smalls.back() == 65535 );
+        CHECK( !smallCli.parse( { "TestApp", "--small=65536" } ) );
+        CHECK( !smallCli.parse( { "TestApp", "--small=-1" } ) );
+
+        std::vector<long long> bigs;
+        auto bigCli = Parser() | Opt( bigs, "big" )["--big"].delimiter( ',' );
+        REQUIRE( bigCli.parse( { "TestApp", "--big=-9223372036854775808,9223372036854775807" } ) );
+        CHECK( bigs[0] == (std::numeric_limits<long long>::min)() );
+        CHECK( bigs[1] == (std::numeric_limits<long long>::max)() );
+        CHECK( !bigCli.parse( { "TestApp", "--big=9223372036854775808" } ) );
+
+        REQUIRE( cli.parse( { "TestApp", "--small", "7", "--big", "8" } ) );
+        CHECK( small == 7 );
+        CHECK( big == 8 );
+    }
+    SECTION( "lambdas too large to hold in place are held on the heap" ) {
+        std::string prefix = "a prefix that is too long for the small string buffer";
+        std::vector<int> padding( 8, 1 );
+        std::string seen;
+        auto cli = Parser() | Opt( [&seen, prefix, padding]( std::string const &s ) { seen = prefix + s; }, "s" )["-s"];
+        prefix.clear();
+
+        REQUIRE( cli.parse( { "TestApp", "-s", "!" } ) );
+        CHECK( seen == "a prefix that is too long for the small string buffer!" );
+    }
+    SECTION( "copies of a parser share their bindings" ) {
+        int value = 0;
+        auto cli = Parser() | Opt( [&value]( int i ) { value = i; }, "i" )["-i"];
+        auto copy = cli;
+
+        REQUIRE( copy.parse( { "TestApp", "-i", "5" } ) );
+        CHECK( value == 5 );
+    }
+}
+
+TEST_CASE( "deferred validators" ) {
+    auto missing = []( std::string const &file ) {
+        return file.compare( 0, 7, "missing" ) == 0
+            ? ParserResult::runtimeError( "No such file: " + file )
+            : ParserResult::ok( ParseResultType::Matched );
+    };
+
+    SECTION( "run once the whole command line has parsed" ) {
+        int count = 0;
+        int countWhenValidated = -1;
+        std::string name;
+        auto cli
+            = Opt( name, "name" )["-n"].validatedBy( [&]( std::string const & ) {
+                countWhenValidated = count;
+                return ParserResult::ok( ParseResultType::Matched );
+            } )
+            | Opt( count, "count" )["-c"];
+
+        REQUIRE( cli.parse( { "TestApp", "-n", "Bill", "-c", "3" } ) );
+        CHECK( countWhenValidated == 3 );
+    }
+    SECTION( "are not run if parsing fails" ) {
+        std::atomic<int> calls( 0 );
+        std::vector<std::string> files;
+        auto cli = Parser() | Arg( files, "files" ).validatedBy( [&]( std::string const & ) {
+            ++calls;
+            return ParserResult::ok( ParseResultType::Matched );
+        } );
+
+        CHECK_FALSE( cli.parse( { "TestApp", "a.txt", "--wat" } ) );
+        CHECK( calls == 0 );
+    }
+    SECTION( "errors are reported in token order" ) {
+        std::vector<std::string> files;
+        std::string output;
+        auto cli
+            = Opt( output, "file" )["-o"].validatedBy( missing )
+            | Arg( files, "files" ).validatedBy( missing );
+#ifdef CLARA_CONFIG_PARALLEL_VALIDATION
+        cli.validationThreads( 4 );
+#endif
+
+        std::vector<std::string> args{ "TestApp" };
+        for( int i = 0; i < 200; ++i )
+            args.push_back( ( i % 50 == 7 ? "missing" : "file" ) + std::to_string( i ) );
+        args.insert( args.begin() + 100, "-o" );
+        args.insert( args.begin() + 101, "missing-output" );
+        std::vector<char const *> argv;
+        for( auto const &arg : args )
+            argv.push_back( arg.c_str() );
+
+        auto result = cli.parse( Args( static_cast<int>( argv.size() ), argv.data() ) );
+        REQUIRE_FALSE( result );
+        CHECK( result.errorMessage() ==
+            "No such file: missing7\nNo such file: missing57\nNo such file: missing-output\n"
+            "No such file: missing107\nNo such file: missing157" );
+        CHECK( files.size() == 200 ); // The values are still set
+    }
+#ifdef CLARA_CONFIG_PARALLEL_VALIDATION
+    SECTION( "run on the worker pool" ) {
+        std::mutex mutex;
+        std::set<std::thread::id> threadIds;
+        std::vector<std::string> files;
+        auto cli = Parser() | Arg( files, "files" ).validatedBy( [&]( std::string const & ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+            std::lock_guard<std::mutex> lock( mutex );
+            threadIds.insert( std::this_thread::get_id() );
+            return ParserResult::ok( ParseResultType::Matched );
+        } );
+
+        std::vector<std::string> args( 65, "file" );
+        std::vector<char const *> argv;
+        for( auto const &arg : args )
+            argv.push_back( arg.c_str() );
+
+        SECTION( "of bounded size" ) {
+            cli.validationThreads( 4 );
+            REQUIRE( cli.parse( Args( static_cast<int>( argv.size() ), argv.data() ) ) );
+            if( detail::WorkerPool::maxThreads() > 1 )
+                CHECK( threadIds.size() > 1 );
+            CHECK( threadIds.size() <= (std::min)( size_t( 4 ), detail::WorkerPool::maxThreads() ) );
+        }
+        SECTION( "of at most one thread per core" ) {
+            cli.validationThreads( 1000 );
+            REQUIRE( cli.parse( Args( static_cast<int>( argv.size() ), argv.data() ) ) );
+            CHECK( threadIds.size() <= detail::WorkerPool::maxThreads() );
+            CHECK( detail::WorkerPool::instance().workerCount() < detail::WorkerPool::maxThreads() );
+        }
+        SECTION( "or on this thread alone" ) {
+            cli.validationThreads( 1 );
+            REQUIRE( cli.parse( Args( static_cast<int>( argv.size() ), argv.data() ) ) );
+            CHECK( threadIds == std::set<std::thread::id>{ std::this_thread::get_id() } );
+        }
+    }
+#endif
+    SECTION( "exceptions are rethrown from the earliest token" ) {
+        std::vector<std::string> files;
+        auto cli = Parser() | Arg( files, "files" ).validatedBy( []( std::string const &file ) -> ParserResult {
+            throw std::runtime_error( "threw for " + file );
+        } );
+#ifdef CLARA_CONFIG_PARALLEL_VALIDATION
+        cli.validationThreads( 2 );
+#endif
+
+        try {
+            cli.parse( { "TestApp", "a", "b", "c" } );
+            FAIL( "expected an exception" );
+        }
+        catch( std::runtime_error const &ex ) {
+            CHECK( std::string( ex.what() ) == "threw for a" );
+        }
+    }
+    SECTION( "collecting errors records each failure" ) {
+        std::vector<std::string> files;
+        std::string output;
+        auto cli
+            = Opt( output, "file" )["-o"].validatedBy( missing )
+            | Arg( files, "files" ).validatedBy( missing );
+
+        auto result = cli.parseCollectingErrors( { "TestApp", "missing1", "-o", "missing2", "file3", "--wat" } );
+        REQUIRE( result );
+        auto const &diagnostics = result.value();
+        REQUIRE( diagnostics.size() == 3 );
+        CHECK( diagnostics[0].kind == DiagnosticKind::UnrecognisedToken );
+        CHECK( diagnostics[1].kind == DiagnosticKind::ValidationFailed );
+        CHECK( diagnostics[1].message == "No such file: missing1" );
+        CHECK( diagnostics[1].token == 0 );
+        CHECK( diagnostics[1].arg == 1 );
+        CHECK( diagnostics[2].kind == DiagnosticKind::ValidationFailed );
+        CHECK( diagnostics[2].message == "No such file: missing2" );
+        CHECK( diagnostics[2].token == 2 );
+        CHECK( diagnostics[2].arg == 3 );
+    }
+    SECTION( "flags cannot have validators" ) {
+        bool flag = false;
+        auto result = ( Parser() | Opt( flag )["-f"].validatedBy( missing ) ).parse( { "TestApp", "-f" } );
+        CHECK( result.type() == detail::ResultBase::LogicError );
+    }
+}
@@ -0,0 +1,9 @@
+// The clara library: the non-template parts of clara.hpp, compiled once for code that is built
+// with CLARA_CONFIG_SEPARATE_COMPILATION (as the clara target in CMakeLists.txt is).
+// Any other CLARA_CONFIG_ macros must be defined here just as they are for that code
+
+#ifndef CLARA_CONFIG_SEPARATE_COMPILATION
+#define CLARA_CONFIG_SEPARATE_COMPILATION
+#endif
+#define CLARA_IMPLEMENTATION
+#include "clara.hpp"
@@ -10,7 +10,10 @@
 #ifndef TEXTFLOW_HPP_INCLUDED
 #define TEXTFLOW_HPP_INCLUDED
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <ostream>
 #include <sstream>
 #include <vector>
@@ -35,6 +38,87 @@ namespace TextFlow {
         return chars.find( c ) != std::string::npos;
     }
 
+    // Text is measured in display columns, decoding UTF-8. Most characters take one column,
+    // East Asian wide characters take two and combining marks none. Plain ASCII, by far the
+    // most common case, is detected eight bytes at a time and then measured by its length
+
+    inline auto isAscii( char const* text, size_t size ) -> bool {
+        std::uint64_t bits = 0;
+        size_t i = 0;
+        for( ; i + 8 <= size; i += 8 ) {
+            std::uint64_t word;
+            std::memcpy( &word, text + i, 8 );
+            bits |= word;
+        }
+        for( ; i < size; ++i )
+            bits |= static_cast<unsigned char>( text[i] );
+        return ( bits & 0x8080808080808080ull ) == 0;
+    }
+
+    // Decodes the code point starting at pos, returning its length in bytes.
+    // Invalid or truncated sequences are taken a byte at a time
+    inline auto decodeUtf8( std::string const& text, size_t pos, size_t end, std::uint32_t& codePoint ) -> size_t {
+        auto lead = static_cast<unsigned char>( text[pos] );
+        size_t length = lead < 0x80 ? 1 : ( lead & 0xe0 ) == 0xc0 ? 2 : ( lead & 0xf0 ) == 0xe0 ? 3 : ( lead & 0xf8 ) == 0xf0 ? 4 : 0;
+        if( length == 0 || pos + length > end ) {
+            codePoint = lead;
+            return 1;
+        }
+        codePoint = length == 1 ? lead : lead & ( 0x7f >> length );
+        for( size_t i = 1; i < length; ++i ) {
+            auto next = static_cast<unsigned char>( text[pos + i] );
+            if( ( next & 0xc0 ) != 0x80 ) {
+                codePoint = lead;
+                return 1;
+            }
+            codePoint = ( codePoint << 6 ) | ( next & 0x3f );
+        }
+        return length;
+    }
+
+    inline auto codePointWidth( std::uint32_t c ) -> size_t {
+        if( ( c >= 0x0300 && c <= 0x036f ) || ( c >= 0x1ab0 && c <= 0x1aff ) || ( c >= 0x1dc0 && c <= 0x1dff ) ||
+            ( c >= 0x200b && c <= 0x200f ) || ( c >= 0x20d0 && c <= 0x20ff ) || ( c >= 0xfe00 && c <= 0xfe0f ) ||
+            ( c >= 0xfe20 && c <= 0xfe2f ) )
+            return 0;
+        if( ( c >= 0x1100 && c <= 0x115f ) || ( c >= 0x2e80 && c <= 0xa4cf && c != 0x303f ) || ( c >= 0xac00 && c <= 0xd7a3 ) ||
+            ( c >= 0xf900 && c <= 0xfaff ) || ( c >= 0xfe30 && c <= 0xfe4f ) || ( c >= 0xff00 && c <= 0xff60 ) ||
+            ( c >= 0xffe0 && c <= 0xffe6 ) || ( c >= 0x1f300 && c <= 0x1f64f ) || ( c >= 0x1f900 && c <= 0x1f9ff ) ||
+            ( c >= 0x20000 && c <= 0x3fffd ) )
+            return 2;
+        return 1;
+    }
+
+    inline auto displayWidth( std::string const& text, size_t pos, size_t end ) -> size_t {
+        if( isAscii( text.data() + pos, end - pos ) )
+            return end - pos;
+        size_t width = 0;
+        std::uint32_t codePoint;
+        while( pos < end ) {
+            pos += decodeUtf8( text, pos, end, codePoint );
+            width += codePointWidth( codePoint );
+        }
+        return width;
+    }
+    inline auto displayWidth( std::string const& text ) -> size_t {
+        return displayWidth( text, 0, text.size() );
+    }
+
+    // The number of bytes, from pos, of the whole code points that fit in the width.
+    // Zero width code points that follow are included, so marks stay with what they combine with
+    inline auto bytesInWidth( std::string const& text, size_t pos, size_t end, size_t width ) -> size_t {
+        size_t start = pos, used = 0;
+        std::uint32_t codePoint;
+        while( pos < end ) {
+            auto length = decodeUtf8( text, pos, end, codePoint );
+            used += codePointWidth( codePoint );
+            if( used > width )
+                break;
+            pos += length;
+        }
+        return pos - start;
+    }
+
     class Columns;
 
     class Column {
@@ -77,15 +161,17 @@ namespace TextFlow {
 
                 m_suffix = false;
                 auto width = m_column.m_width-indent();
-                m_end = m_pos;
-                while( m_end < line().size() && line()[m_end] != '\n' )
-                    ++m_end;
+                auto newline = static_cast<char const*>( std::memchr( line().data() + m_pos, '\n', line().size() - m_pos ) );
+                m_end = newline ? static_cast<size_t>( newline - line().data() ) : line().size();
 
-                if( m_end < m_pos + width ) {
+                auto ascii = isAscii( line().data() + m_pos, m_end - m_pos );
+                if( ( ascii ? m_end - m_pos : displayWidth( line(), m_pos, m_end ) ) < width ) {
                     m_len = m_end - m_pos;
                 }
                 else {
-                    size_t len = width;
+                    // Boundaries are only ever found between whole code points, as every
+                    // byte of a multibyte sequence is outside the ASCII range
+                    size_t len = ascii ? width : bytesInWidth( line(), m_pos, m_end, width );
                     while (len > 0 && !isBoundary(m_pos + len))
                         --len;
                     while (len > 0 && isWhitespace( line()[m_pos + len - 1] ))
@@ -93,9 +179,14 @@ namespace TextFlow {
 
                     if (len > 0) {
                         m_len = len;
-                    } else {
+                    } else if( ascii ) {
                         m_suffix = true;
                         m_len = width - 1;
+                    } else {
+                        // Always take at least one code point, so a character wider than the column still makes progress
+                        std::uint32_t codePoint;
+                        m_suffix = true;
+                        m_len = (std::max)( bytesInWidth( line(), m_pos, m_end, width - 1 ), decodeUtf8( line(), m_pos, m_end, codePoint ) );
                     }
                 }
             }
@@ -267,8 +358,9 @@ namespace TextFlow {
                     if( m_iterators[i] != m_columns[i].end() ) {
                         std::string col = *m_iterators[i];
                         row += padding + col;
-                        if( col.size() < width )
-                            padding = std::string( width - col.size(), ' ' );
+                        auto colWidth = displayWidth( col );
+                        if( colWidth < width )
+                            padding = std::string( width - colWidth, ' ' );
                         else
                             padding = "";
                     }